@@ -0,0 +1,165 @@
+// Compares the grid's per-frame culling and draw loop over the old
+// array-of-structs ImagesPair against ImageLibrary's split hot/cold arrays.
+//
+// Build and run on a Linux host from the repository root:
+//   g++ -O2 -std=c++20 -Iinclude benchmarks/LibraryLayoutBenchmark.cpp src/ImageLibrary.cpp src/PathTable.cpp src/SelectionModel.cpp src/ScreenshotScanner.cpp src/ScreenshotFormat.cpp src/DirectoryEnumerator.cpp -o library_layout_benchmark
+//   ./library_layout_benchmark [pairs] [frames]
+//
+// Drawing is reduced to folding what SDL_RenderCopy would be handed into a
+// checksum, so the numbers are the cost of walking the library itself. The
+// memory held by paths in both layouts is printed as well.
+#include <ImageLibrary.h>
+#include <SelectionModel.h>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#define GRID_SIZE     4
+#define ROW_PITCH     300
+#define TILE_HEIGHT   202
+#define HEADER_HEIGHT 256
+#define SCREEN_HEIGHT 1080
+
+// The layout before the split: layout, selection and textures next to two
+// heap allocated paths
+struct LegacyImagesPair {
+    void *textureTV;
+    void *textureDRC;
+    int x, y;
+    bool selected;
+    std::string pathTV;
+    std::string pathDRC;
+};
+
+#define PAIRS_PER_FOLDER 500
+
+static std::string makeFolder(int index) {
+    char folder[64];
+    snprintf(folder, sizeof(folder), "fs:/vol/external01/wiiu/screenshots/Game %03d", index / PAIRS_PER_FOLDER);
+    return folder;
+}
+
+static std::string makeStem(int index) {
+    char stem[64];
+    snprintf(stem, sizeof(stem), "2024-01-01_00-%02d-%02d-%03d", index / 60 % 60, index % 60, index % 1000);
+    return stem;
+}
+
+static bool isVisible(int top) {
+    return top + TILE_HEIGHT >= HEADER_HEIGHT / 2 && top <= SCREEN_HEIGHT;
+}
+
+// Index of the first pair on a visible row, both visible row walks start here
+static int getFirstVisible(int scroll) {
+    int hidden = HEADER_HEIGHT / 2 - HEADER_HEIGHT - scroll - TILE_HEIGHT;
+    return hidden > 0 ? (hidden + ROW_PITCH - 1) / ROW_PITCH * GRID_SIZE : 0;
+}
+
+static int getScroll(int frame, int frames, int pairs) {
+    int contentHeight = (pairs + GRID_SIZE - 1) / GRID_SIZE * ROW_PITCH;
+    return -static_cast<int>(static_cast<int64_t>(contentHeight) * frame / frames);
+}
+
+template<typename Function>
+static double measure(const char *name, int frames, Function frame) {
+    uint64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; i++) {
+        checksum += frame(i);
+    }
+    double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / frames;
+    printf("%-28s %9.2f us/frame  (checksum %llx)\n", name, micros, static_cast<unsigned long long>(checksum));
+    return micros;
+}
+
+int main(int argc, char **argv) {
+    int pairs = argc > 1 ? atoi(argv[1]) : 20000;
+    int frames = argc > 2 ? atoi(argv[2]) : 2000;
+
+    std::vector<LegacyImagesPair> legacy;
+    legacy.reserve(pairs);
+    ImageLibrary library;
+    std::vector<SlotHandle> displayOrder;
+    library.reserve(pairs);
+    displayOrder.reserve(pairs);
+    SelectionModel selection;
+    selection.resize(pairs);
+    for (int i = 0; i < pairs; i++) {
+        std::string prefix = makeFolder(i) + "/" + makeStem(i);
+        legacy.push_back({reinterpret_cast<void *>(static_cast<uintptr_t>(0x1000 + i * 16)), reinterpret_cast<void *>(static_cast<uintptr_t>(0x2000 + i * 16)),
+                          i % GRID_SIZE * ROW_PITCH, i / GRID_SIZE * ROW_PITCH, i % 7 == 0, prefix + "_TV.jpg", prefix + "_DRC.jpg"});
+        if (i % PAIRS_PER_FOLDER == 0) {
+            library.addFolder(makeFolder(i));
+        }
+        SlotHandle handle = library.add(i / PAIRS_PER_FOLDER, makeStem(i), ImageFormat::JPG, ImageFormat::JPG);
+        library.setThumbnails(handle, i % 160, (i + 80) % 160);
+        displayOrder.push_back(handle);
+        selection.set(i, i % 7 == 0);
+    }
+    printf("%d pairs, %d frames, sizeof(LegacyImagesPair) = %zu\n", pairs, frames, sizeof(LegacyImagesPair));
+
+    size_t legacyPathBytes = 0;
+    for (const auto &image : legacy) {
+        legacyPathBytes += sizeof(std::string) * 2 + image.pathTV.capacity() + 1 + image.pathDRC.capacity() + 1;
+    }
+    printf("path memory: %zu KiB as strings, %zu KiB in the path table\n", legacyPathBytes / 1024, library.getPathMemoryUsage() / 1024);
+
+    double before = measure("AoS, every pair", frames, [&](int frame) {
+        int scroll = getScroll(frame, frames, pairs);
+        uint64_t sum = 0;
+        for (const auto &image : legacy) {
+            int top = HEADER_HEIGHT + image.y + scroll;
+            if (isVisible(top)) {
+                sum += reinterpret_cast<uintptr_t>(image.textureTV) ^ reinterpret_cast<uintptr_t>(image.textureDRC) ^ image.x ^ top ^ image.selected;
+            }
+        }
+        return sum;
+    });
+
+    double allPairs = measure("SoA, every pair", frames, [&](int frame) {
+        int scroll = getScroll(frame, frames, pairs);
+        uint64_t sum = 0;
+        for (int i = 0; i < static_cast<int>(displayOrder.size()); i++) {
+            int top = HEADER_HEIGHT + i / GRID_SIZE * ROW_PITCH + scroll;
+            if (isVisible(top)) {
+                SlotHandle handle = displayOrder[i];
+                sum += library.getThumbnailTV(handle) ^ library.getThumbnailDRC(handle) ^ i % GRID_SIZE * ROW_PITCH ^ top ^ selection.isSelected(i);
+            }
+        }
+        return sum;
+    });
+
+    double beforeVisibleRows = measure("AoS, visible rows only", frames, [&](int frame) {
+        int scroll = getScroll(frame, frames, pairs);
+        uint64_t sum = 0;
+        for (int i = getFirstVisible(scroll); i < static_cast<int>(legacy.size()); i++) {
+            const LegacyImagesPair &image = legacy[i];
+            int top = HEADER_HEIGHT + image.y + scroll;
+            if (!isVisible(top)) {
+                break;
+            }
+            sum += reinterpret_cast<uintptr_t>(image.textureTV) ^ reinterpret_cast<uintptr_t>(image.textureDRC) ^ image.x ^ top ^ image.selected;
+        }
+        return sum;
+    });
+
+    double visibleRows = measure("SoA, visible rows only", frames, [&](int frame) {
+        int scroll = getScroll(frame, frames, pairs);
+        uint64_t sum = 0;
+        for (int i = getFirstVisible(scroll); i < static_cast<int>(displayOrder.size()); i++) {
+            int top = HEADER_HEIGHT + i / GRID_SIZE * ROW_PITCH + scroll;
+            if (!isVisible(top)) {
+                break;
+            }
+            SlotHandle handle = displayOrder[i];
+            sum += library.getThumbnailTV(handle) ^ library.getThumbnailDRC(handle) ^ i % GRID_SIZE * ROW_PITCH ^ top ^ selection.isSelected(i);
+        }
+        return sum;
+    });
+
+    printf("speedup: %.1fx every pair, %.1fx visible rows only\n", before / allPairs, beforeVisibleRows / visibleRows);
+    return 0;
+}
@@ -0,0 +1,96 @@
+// Compares the directory enumeration backends on a generated screenshot tree.
+//
+// Build and run on a Linux host from the repository root:
+//   g++ -O2 -std=c++20 -Iinclude benchmarks/ScanBenchmark.cpp src/DirectoryEnumerator.cpp src/ScreenshotScanner.cpp src/ScreenshotFormat.cpp -o scan_benchmark
+//   ./scan_benchmark [folders] [pairs per folder] [iterations]
+//
+// The tree is generated once, so both backends run against a warm dentry
+// cache. That isolates the per-entry overhead (stat calls, allocations) which
+// is what dominates on the console's FAT-formatted SD card.
+#include <DirectoryEnumerator.h>
+#include <ScreenshotScanner.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+class CountingVisitor : public DirectoryVisitor {
+public:
+    bool onDirectory(std::string_view) override {
+        directories++;
+        return true;
+    }
+
+    void onFile(std::string_view) override {
+        files++;
+    }
+
+    size_t directories = 0;
+    size_t files = 0;
+};
+
+static void generateTree(const std::filesystem::path &root, int folders, int pairsPerFolder) {
+    std::filesystem::remove_all(root);
+    char name[64];
+    for (int folder = 0; folder < folders; folder++) {
+        std::filesystem::path directory = root / ("Game " + std::to_string(folder));
+        std::filesystem::create_directories(directory);
+        for (int pair = 0; pair < pairsPerFolder; pair++) {
+            snprintf(name, sizeof(name), "2024-%02d-%02d_%02d-%02d-%02d", pair % 12 + 1, pair % 28 + 1, pair % 24, pair % 60, folder % 60);
+            std::ofstream(directory / (std::string(name) + "_" + std::to_string(pair) + "_TV.jpg"));
+            std::ofstream(directory / (std::string(name) + "_" + std::to_string(pair) + "_DRC.jpg"));
+        }
+        std::ofstream(directory / "desktop.ini");
+    }
+}
+
+template<typename Function>
+static double medianMilliseconds(int iterations, Function function) {
+    std::vector<double> samples;
+    for (int i = 0; i < iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        samples.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+int main(int argc, char **argv) {
+    int folders = argc > 1 ? atoi(argv[1]) : 100;
+    int pairsPerFolder = argc > 2 ? atoi(argv[2]) : 100;
+    int iterations = argc > 3 ? atoi(argv[3]) : 15;
+
+    std::filesystem::path root = std::filesystem::temp_directory_path() / "screenshot_scan_benchmark";
+    generateTree(root, folders, pairsPerFolder);
+    printf("tree: %d folders, %d files\n", folders, folders * (pairsPerFolder * 2 + 1));
+
+    const struct {
+        const char *name;
+        DirectoryBackend backend;
+    } backends[] = {
+            {"filesystem", DirectoryBackend::Filesystem},
+            {"posix", DirectoryBackend::Posix},
+    };
+
+    for (const auto &backend : backends) {
+        auto enumerator = createDirectoryEnumerator(backend.backend);
+        CountingVisitor visitor;
+        double enumerateTime = medianMilliseconds(iterations, [&] {
+            visitor = CountingVisitor();
+            enumerator->enumerate(root.string(), visitor);
+        });
+
+        ScreenshotScanner scanner;
+        double scanTime = medianMilliseconds(iterations, [&] { scanner.scan(root.string(), backend.backend); });
+
+        printf("%-10s  enumerate %8.2f ms (%zu files)   full scan %8.2f ms (%zu pairs)\n", backend.name, enumerateTime, visitor.files, scanTime, scanner.getPairs().size());
+    }
+
+    std::filesystem::remove_all(root);
+    return 0;
+}
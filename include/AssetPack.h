@@ -0,0 +1,61 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <cstddef>
+#include <cstdint>
+
+#define ASSET_PACK_PATH        "romfs:/ui_assets.pack"
+#define ASSET_PACK_MAGIC       0x4B504955 // "UIPK" read as little-endian
+#define ASSET_PACK_VERSION     1
+#define ASSET_PACK_NAME_LENGTH 32
+
+// Pre-decoded UI art produced by pack_ui_assets.py. Pixels are stored as
+// RGBA32 so they can be handed to SDL_UpdateTexture without conversion.
+enum class AssetEncoding : uint32_t {
+    Raw = 0,
+    RLE = 1,
+};
+
+struct AssetPackHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+};
+
+struct AssetPackEntry {
+    char name[ASSET_PACK_NAME_LENGTH];
+    uint32_t width;
+    uint32_t height;
+    uint32_t offset;
+    uint32_t size;
+    uint32_t encoding;
+    uint32_t reserved;
+};
+
+class AssetPack {
+public:
+    AssetPack() = default;
+
+    ~AssetPack();
+
+    AssetPack(const AssetPack &) = delete;
+
+    AssetPack &operator=(const AssetPack &) = delete;
+
+    bool open(const char *path);
+
+    void close();
+
+    bool isOpen() const;
+
+    SDL_Texture *loadTexture(SDL_Renderer *renderer, const char *name) const;
+
+private:
+    const AssetPackEntry *findEntry(const char *name) const;
+
+    uint8_t *data = nullptr;
+    size_t size = 0;
+    bool mapped = false;
+    uint32_t entryCount = 0;
+};
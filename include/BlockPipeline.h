@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define PIPELINE_BLOCK_SIZE      (1024 * 1024) // per read and write, large enough to stream
+#define PIPELINE_BLOCK_ALIGNMENT 0x40          // FS transfers into unaligned memory go through a bounce buffer
+
+struct PipelineBlock {
+    std::unique_ptr<uint8_t, decltype(&free)> data{nullptr, free};
+    size_t size = 0;
+    uint32_t file = 0;
+    bool first = false;  // start of its file
+    bool last = false;   // end of its file
+    bool failed = false; // the file could not be read, drop it
+    bool filled = false;
+};
+
+// Two aligned blocks handed back and forth between a reader and a writer
+// thread, so one is being filled while the other is being written out.
+// Blocks are consumed in the order they were filled.
+class BlockPipeline {
+public:
+    bool allocate();
+
+    // Reader side: the next empty block, nullptr once the writer stopped
+    PipelineBlock *acquireEmpty();
+
+    void publish(PipelineBlock *block);
+
+    // Writer side: the next filled block, nullptr once the reader finished
+    PipelineBlock *acquireFilled();
+
+    void release(PipelineBlock *block);
+
+    // The reader has nothing more to publish
+    void finish();
+
+    // The writer gives up, the reader stops at its next block
+    void stop();
+
+private:
+    PipelineBlock blocks[2];
+    int readIndex = 0;
+    int writeIndex = 0;
+    bool finished = false;
+    bool stopped = false;
+    std::mutex mutex;
+    std::condition_variable changed;
+};
+
+// Reader loop: streams every file through the pipeline in order with
+// unbuffered block-sized reads, then finishes it. A file that cannot be
+// opened or read still gets one block, flagged as failed and last.
+void readFilesIntoPipeline(const std::vector<std::string> &paths, BlockPipeline &pipeline, const std::atomic<bool> &cancelled);
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <ImageProbe.h>
+#include <ScreenshotScanner.h>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#define CAPTURE_TIME_UNKNOWN 0
+
+// Capture times are packed as the decimal digits YYYYMMDDhhmmssmmm, so they
+// compare like the times they stand for and sort as plain integers.
+
+// Finds a "YYYY-MM-DD_hh-mm-ss" timestamp, optionally followed by
+// milliseconds, anywhere in the text. Any of "-_: ." separate the fields,
+// which also covers the EXIF "YYYY:MM:DD hh:mm:ss" form.
+uint64_t parseCaptureTime(std::string_view text);
+
+// "YYYY-MM-DD hh:mm:ss", or an empty string for an unknown time
+void formatCaptureTime(uint64_t captureTime, char *text, size_t size);
+
+// The name is tried first; the headers are only probed for JPEGs without a
+// timestamp in their name
+uint64_t getPairCaptureTime(const ScreenshotScanner &scanner, const ScreenshotPair &pair, ImageProbe &probe);
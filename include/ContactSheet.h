@@ -0,0 +1,33 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define CONTACT_SHEET_COLUMNS      6
+#define CONTACT_SHEET_CELL_WIDTH   320
+#define CONTACT_SHEET_CELL_HEIGHT  180
+#define CONTACT_SHEET_SPACING      8
+#define CONTACT_SHEET_BACKGROUND   0x20 // gray level around and behind the cells
+#define CONTACT_SHEET_WORKER_COUNT 3    // one core stays with the UI and the encoder
+
+// Written by the workers, read by the UI. Setting `cancelled` stops after the
+// cells being decoded and leaves no file behind.
+struct ContactSheetProgress {
+    std::atomic<uint32_t> cellsDone{0};
+    std::atomic<uint32_t> cellsFailed{0};
+    std::atomic<bool> cancelled{false};
+};
+
+// Box-filters an RGB24 image into a smaller (or, nearest-neighbour, larger)
+// RGB24 rectangle. Source rows are summed into a row of totals first, so the
+// inner loops run straight over bytes.
+void boxDownsample(const uint8_t *source, int sourceWidth, int sourceHeight, size_t sourcePitch, uint8_t *destination, int width, int height, size_t pitch);
+
+// Renders the images, in order, into one PNG grid of aspect-fit cells. The
+// sheet is built a row of cells at a time: workers decode and scale the cells
+// of the next two rows while the calling thread encodes the finished one, so
+// memory stays at two strips plus one decoded image per worker however many
+// images there are. Images that fail to decode leave an empty cell.
+bool writeContactSheet(const std::vector<std::string> &paths, const std::string &outputPath, ContactSheetProgress &progress);
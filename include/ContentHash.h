@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Streaming XXH64. Fast enough to keep up with the SD card, and only used to
+// tell files apart, never for security.
+class ContentHasher {
+public:
+    explicit ContentHasher(uint64_t seed = 0);
+
+    void update(const uint8_t *data, size_t size);
+
+    uint64_t digest() const;
+
+private:
+    uint64_t lanes[4];
+    uint64_t seed;
+    uint64_t totalSize = 0;
+    uint8_t stripe[32]; // bytes of an incomplete stripe between updates
+    size_t stripeSize = 0;
+};
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// CRC-32 as used by ZIP and PNG. Start with 0 and feed data in any number of
+// pieces; slicing-by-8 tables handle eight bytes per step.
+uint32_t updateCrc32(uint32_t crc, const uint8_t *data, size_t size);
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+enum class DirectoryBackend {
+    Filesystem, // std::filesystem::directory_iterator
+    Posix,      // readdir/getdents, trusting d_type where the platform fills it
+};
+
+class DirectoryVisitor {
+public:
+    virtual ~DirectoryVisitor() = default;
+
+    // Called before the files of a directory are reported. Returning false
+    // skips the directory and everything below it.
+    virtual bool onDirectory(std::string_view path) = 0;
+
+    // Called for every regular file of the directory last passed to onDirectory
+    virtual void onFile(std::string_view name) = 0;
+};
+
+// Walks a directory tree one directory at a time: all files of a directory are
+// reported before any of its subdirectories is entered.
+class DirectoryEnumerator {
+public:
+    virtual ~DirectoryEnumerator() = default;
+
+    virtual bool enumerate(const std::string &rootPath, DirectoryVisitor &visitor) = 0;
+};
+
+std::unique_ptr<DirectoryEnumerator> createDirectoryEnumerator(DirectoryBackend backend);
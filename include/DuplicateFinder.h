@@ -0,0 +1,24 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define DUPLICATE_WORKER_COUNT   3
+#define DUPLICATE_READ_SIZE      (256 * 1024) // one read per request keeps the SD card streaming
+#define DUPLICATE_READ_ALIGNMENT 0x40         // FS reads into unaligned buffers go through a bounce buffer
+#define DUPLICATE_GROUP_NONE     UINT32_MAX
+
+// Counters for the progress line, written by the workers
+struct DuplicateProgress {
+    std::atomic<uint32_t> filesSized{0};
+    std::atomic<uint32_t> filesToHash{0};
+    std::atomic<uint32_t> filesHashed{0};
+};
+
+// Groups byte-identical files. Sizes are read first and only files sharing a
+// size with a `wanted` file are hashed, with large sequential reads on a
+// worker pool. Returns a group id per path, DUPLICATE_GROUP_NONE for files
+// without a copy or that could not be read.
+std::vector<uint32_t> findDuplicateFiles(const std::vector<std::string> &paths, const std::vector<uint8_t> &wanted, DuplicateProgress &progress);
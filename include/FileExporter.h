@@ -0,0 +1,30 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define EXPORT_PART_SUFFIX ".part"
+
+struct ExportFile {
+    std::string source;
+    std::string destination;
+};
+
+// Written by the copy, read by the UI. Setting `cancelled` stops the copy
+// after the block in flight; a partly written file is removed.
+struct ExportProgress {
+    std::atomic<uint64_t> bytesTotal{0};
+    std::atomic<uint64_t> bytesCopied{0};
+    std::atomic<uint32_t> filesCopied{0};
+    std::atomic<uint32_t> filesFailed{0};
+    std::atomic<bool> cancelled{false};
+};
+
+// Copies files through a BlockPipeline: a reader thread fills one block while
+// the calling thread writes the other, across file boundaries, so the source
+// and destination are busy at the same time. Each file is written under a
+// ".part" name and renamed when complete, replacing an older copy.
+// Destination directories must exist. Returns true if every file was copied.
+bool exportFiles(const std::vector<ExportFile> &files, ExportProgress &progress);
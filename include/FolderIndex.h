@@ -0,0 +1,95 @@
+#pragma once
+
+#include <DirectoryEnumerator.h>
+#include <ScanProgress.h>
+#include <ScreenshotScanner.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#define FOLDER_INDEX_FILE_NAME ".folders.idx"
+#define FOLDER_INDEX_MAGIC     0x58444946 // "FIDX" on little-endian hosts, the file is in host byte order
+#define FOLDER_INDEX_VERSION   2
+
+struct FolderIndexHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+};
+
+// Followed by the folder name and the cover stem, without terminators
+struct FolderIndexRecord {
+    int64_t modifiedTime;
+    uint64_t newestCapture;
+    uint32_t pairCount;
+    uint16_t nameLength;
+    uint16_t stemLength;
+    ImageFormat coverTVFormat;
+    ImageFormat coverDRCFormat;
+    uint8_t reserved[6];
+};
+
+// One per-title folder. The screenshot root itself shows up with an empty
+// name when it holds screenshots directly, as emulator builds do.
+struct FolderEntry {
+    std::string name;
+    int64_t modifiedTime;
+    uint64_t newestCapture; // capture time of the cover
+    uint32_t pairCount;
+    std::string coverStem;
+    ImageFormat coverTVFormat;
+    ImageFormat coverDRCFormat;
+};
+
+// Pair count and cover of every folder under the screenshot root, saved next
+// to the folders so a start only lists the top level. A folder is rescanned
+// when its modification time differs from the saved one; opening a folder
+// scans it anyway and corrects its entry, which covers file systems that do
+// not update directory times.
+class FolderIndex : private DirectoryVisitor {
+public:
+    explicit FolderIndex(const std::string &rootPath);
+
+    // Lists the root and rescans only the folders that changed, then saves
+    // the index if anything did
+    void refresh(ScanProgress *progress = nullptr);
+
+    size_t size() const {
+        return folders.size();
+    }
+
+    const FolderEntry &get(size_t folder) const {
+        return folders[folder];
+    }
+
+    std::string getPath(size_t folder) const;
+
+    // Name shown in the folder grid
+    std::string_view getDisplayName(size_t folder) const;
+
+    // Records what a full scan of an opened folder found. The cover is the
+    // pair with the newest capture time.
+    void update(size_t folder, uint32_t pairCount, uint64_t newestCapture, std::string_view coverStem, ImageFormat coverTVFormat, ImageFormat coverDRCFormat);
+
+    bool save();
+
+private:
+    bool onDirectory(std::string_view path) override;
+
+    void onFile(std::string_view name) override;
+
+    void load(std::vector<FolderEntry> &saved) const;
+
+    void scanFolder(FolderEntry &entry, ScanProgress *progress) const;
+
+    std::string rootPath;
+    std::string indexPath;
+    std::vector<FolderEntry> folders;
+    std::vector<FolderEntry> emptyFolders;
+    std::vector<std::string> listedFolders;
+    bool rootHasScreenshots = false;
+    bool rootListed = false;
+    bool dirty = false;
+};
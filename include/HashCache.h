@@ -0,0 +1,39 @@
+#pragma once
+
+#include <ImageLibrary.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define HASH_CACHE_FILE_NAME ".phash.idx"
+#define HASH_CACHE_MAGIC     0x48534850 // "PHSH" on little-endian hosts, the file is in host byte order
+#define HASH_CACHE_VERSION   2
+
+#define HASH_CACHE_FLAG_HASH         0x01
+#define HASH_CACHE_FLAG_CAPTURE_TIME 0x02 // read from the headers, the name has no timestamp
+
+struct HashCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+};
+
+// Followed by the stem, without a terminator
+struct HashCacheRecord {
+    uint64_t bits;
+    uint64_t captureTime;
+    uint32_t sharpness;
+    uint16_t stemLength;
+    ImageFormat format; // of the hashed half, a converted file is hashed again
+    uint8_t flags;
+};
+
+// Perceptual hashes of one folder, and the capture times its names lack,
+// saved next to its screenshots so a folder only has to be decoded for
+// hashing and probed for EXIF times once. Pairs are matched by stem.
+void loadHashCache(const std::string &folderPath, ImageLibrary &library, const std::vector<SlotHandle> &handles);
+
+// Writes the hashes and header capture times of the pairs in `handles`;
+// deleted pairs drop out
+bool saveHashCache(const std::string &folderPath, const ImageLibrary &library, const std::vector<SlotHandle> &handles);
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <ImageProbe.h>
+#include <PathTable.h>
+#include <PerceptualHash.h>
+#include <SlotMap.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#define THUMBNAIL_SLOT_NONE   0xFFFF // not decoded yet, drawn as the placeholder
+#define THUMBNAIL_SLOT_FAILED 0xFFFE // nothing to show, drawn black
+#define PATH_ID_NONE          UINT32_MAX
+
+#define IMAGE_FLAG_HAS_TV  0x01
+#define IMAGE_FLAG_HAS_DRC 0x02
+#define IMAGE_FLAG_PROBED  0x04 // header metadata of both halves is known
+#define IMAGE_FLAG_HASHED  0x08 // perceptual hash of the TV half, or the DRC half without one
+#define IMAGE_FLAG_TIMED   0x10 // capture time is settled, even if it stayed unknown
+
+// Screenshot pairs stored as parallel arrays. What the grid touches every
+// frame (texture pool slots and flags) sits in small dense arrays; folder and
+// path table ids live in a cold record that is only read for I/O. Every array
+// is indexed by the slot handle's index, so handles stay valid across removals.
+class ImageLibrary {
+public:
+    uint32_t addFolder(std::string_view path);
+
+    // ImageFormat::Unknown marks a missing half of the pair
+    SlotHandle add(uint32_t folder, std::string_view stem, ImageFormat tvFormat, ImageFormat drcFormat);
+
+    bool remove(SlotHandle handle);
+
+    bool contains(SlotHandle handle) const {
+        return records.contains(handle);
+    }
+
+    size_t size() const {
+        return records.size();
+    }
+
+    void reserve(size_t count);
+
+    void clear();
+
+    uint16_t getThumbnailTV(SlotHandle handle) const {
+        return thumbnailTV[handle.index];
+    }
+
+    uint16_t getThumbnailDRC(SlotHandle handle) const {
+        return thumbnailDRC[handle.index];
+    }
+
+    void setThumbnails(SlotHandle handle, uint16_t tv, uint16_t drc) {
+        thumbnailTV[handle.index] = tv;
+        thumbnailDRC[handle.index] = drc;
+    }
+
+    uint8_t getFlags(SlotHandle handle) const {
+        return flags[handle.index];
+    }
+
+    // Packed as in CaptureTime.h, read for every pair on each re-sort
+    uint64_t getCaptureTime(SlotHandle handle) const {
+        return captureTimes[handle.index];
+    }
+
+    void setCaptureTime(SlotHandle handle, uint64_t captureTime) {
+        captureTimes[handle.index] = captureTime;
+        flags[handle.index] |= IMAGE_FLAG_TIMED;
+    }
+
+    // Header metadata, nullptr until the pair has been probed
+    const ImageInfo *getInfo(SlotHandle handle, ScreenshotKind kind) const {
+        if (!(flags[handle.index] & IMAGE_FLAG_PROBED)) {
+            return nullptr;
+        }
+        return kind == ScreenshotKind::TV ? &infoTV[handle.index] : &infoDRC[handle.index];
+    }
+
+    void setInfo(SlotHandle handle, const ImageInfo &tv, const ImageInfo &drc) {
+        infoTV[handle.index] = tv;
+        infoDRC[handle.index] = drc;
+        flags[handle.index] |= IMAGE_FLAG_PROBED;
+    }
+
+    ScreenshotKind getHashedKind(SlotHandle handle) const {
+        return flags[handle.index] & IMAGE_FLAG_HAS_TV ? ScreenshotKind::TV : ScreenshotKind::DRC;
+    }
+
+    // Only meaningful with IMAGE_FLAG_HASHED set
+    const PerceptualHash &getPerceptualHash(SlotHandle handle) const {
+        return hashes[handle.index];
+    }
+
+    void setPerceptualHash(SlotHandle handle, const PerceptualHash &hash) {
+        hashes[handle.index] = hash;
+        flags[handle.index] |= IMAGE_FLAG_HASHED;
+    }
+
+    uint32_t getFolder(SlotHandle handle) const {
+        return records[handle].folder;
+    }
+
+    std::string_view getStem(SlotHandle handle) const;
+
+    // ImageFormat::Unknown when that half is missing
+    ImageFormat getFormat(SlotHandle handle, ScreenshotKind kind) const;
+
+    // Points a present half at its converted file; the probed metadata no
+    // longer applies
+    void setFormat(SlotHandle handle, ScreenshotKind kind, ImageFormat format);
+
+    // Rebuilds the path of one half, empty when that half is missing
+    void buildPath(SlotHandle handle, ScreenshotKind kind, std::string &path) const;
+
+    std::string getPathTV(SlotHandle handle) const;
+
+    std::string getPathDRC(SlotHandle handle) const;
+
+    size_t getPathMemoryUsage() const {
+        return paths.getMemoryUsage();
+    }
+
+private:
+    struct ColdRecord {
+        uint32_t folder;
+        uint32_t pathTV;
+        uint32_t pathDRC;
+    };
+
+    SlotMap<ColdRecord> records;
+    std::vector<uint16_t> thumbnailTV;
+    std::vector<uint16_t> thumbnailDRC;
+    std::vector<uint8_t> flags;
+    std::vector<uint64_t> captureTimes;
+    std::vector<ImageInfo> infoTV;
+    std::vector<ImageInfo> infoDRC;
+    std::vector<PerceptualHash> hashes;
+    PathTable paths;
+};
@@ -1,35 +1,44 @@
 #pragma once
 
 #include <Button.h>
+#include <ImageLibrary.h>
+#include <ImageProbe.h>
 #include <SDL2/SDL.h>
 #include <SDL_FontCache.h>
+#include <ZoomView.h>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 
 #define SCREEN_WIDTH  1920
 #define SCREEN_HEIGHT 1080
 
-struct ImagesPair {
-    SDL_Texture *textureTV;
-    SDL_Texture *textureDRC;
-    int x, y;
-    bool selected;
-    std::string pathTV;
-    std::string pathDRC;
+#define INFO_OVERLAY_HEIGHT 90
 
-    bool operator==(const ImagesPair &other) const {
-        return pathTV == other.pathTV && pathDRC == other.pathDRC;
-    }
-};
+#define IMAGE_PAIR_THREAD_PRIORITY 17 // the image in view was asked for, ahead of slideshow prefetch
 
 enum class SingleImageState {
     TV,
     DRC,
 };
 
+// Largest rect with the image's aspect ratio centred in `box`, taking EXIF
+// rotation into account. Without dimensions the image fills the box.
+SDL_Rect fitImageRect(const ImageInfo *info, const SDL_Rect &box);
+
+// Draws a texture decoded as stored, turned upright and letterboxed in `box`
+void renderFittedImage(SDL_Renderer *renderer, SDL_Texture *texture, const ImageInfo *info, const SDL_Rect &box);
+
 class ImagePairScreen {
 public:
-    ImagePairScreen(ImagesPair *imagesPair, SDL_Texture *arrowTexture, SDL_Renderer *renderer)
-        : imagesPair(imagesPair), arrowTexture(arrowTexture), renderer(renderer), animationSteps(50),
+    // Looked up every frame, the pool may evict or reuse a thumbnail's texture
+    using ThumbnailFunction = std::function<SDL_Texture *(SlotHandle imagesPair, ScreenshotKind kind)>;
+
+    ImagePairScreen(const ImageLibrary *library, SDL_Texture *arrowTexture, SDL_Renderer *renderer, FC_Font *font)
+        : library(library), arrowTexture(arrowTexture), renderer(renderer), font(font), zoomView(renderer), animationSteps(50),
           animationStep(0), arrowVisible(true), arrowButton(0, (SCREEN_HEIGHT / 2) - 145, 290, 290, arrowTexture, nullptr, "", SDL_Color({0, 0, 0, 0})) {
         fullscreenTVRect = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
         fullscreenDRCRect = {SCREEN_WIDTH, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
@@ -44,26 +53,83 @@ public:
             }
             animationStep = 1;
             arrowVisible = false;
+            resetZoom();
         });
+        decodeThread = std::thread(&ImagePairScreen::decodeLoop, this);
     }
 
     void handleEvent(const SDL_Event &event);
 
-    void render();
+    // `seconds` since the last frame drives stick zooming and panning
+    void render(float seconds);
+
+    ~ImagePairScreen();
+
+    void setThumbnailFunction(ThumbnailFunction thumbnailFunction) {
+        this->thumbnailFunction = std::move(thumbnailFunction);
+    }
+
+    // The full resolution images are decoded in the background, the
+    // thumbnails are drawn until they are uploaded
+    void setImagePair(SlotHandle imagesPair);
 
-    void setImagePair(ImagesPair *imagesPair);
+    // Frees the full resolution textures, the grid only keeps thumbnails
+    void releaseTextures();
+
+    // Size, format, file size and capture time of the image in view
+    void toggleInfo() {
+        infoVisible = !infoVisible;
+    }
 
 private:
-    ImagesPair *imagesPair;
+    void renderInfo(const ImageInfo &info);
+
+    SDL_Texture *getTexture(ScreenshotKind kind) const;
+
+    // Probes the pair's headers if needed, then decodes the halves one after
+    // the other, TV first
+    void decodeLoop();
+
+    // Turns at most one decoded half into a texture per frame
+    void uploadDecoded();
+
+    // Points the zoom at the image in view; rotated images stay fitted
+    void resetZoom();
+
+    const ImageLibrary *library;
+    SlotHandle imagesPair;
+    ThumbnailFunction thumbnailFunction;
+    SDL_Texture *fullTextureTV = nullptr;
+    SDL_Texture *fullTextureDRC = nullptr;
+    // Kept only for images the zoom view builds levels for, it makes them from these
+    std::shared_ptr<SDL_Surface> fullPixelsTV;
+    std::shared_ptr<SDL_Surface> fullPixelsDRC;
     SDL_Texture *arrowTexture;
     Button arrowButton;
     SDL_Renderer *renderer;
+    FC_Font *font;
+    ZoomView zoomView;
+    ImageProbe probe; // used by the decode thread only
+    ImageInfo infoTV{};
+    ImageInfo infoDRC{};
+    bool infoVisible = false;
     int animationSteps;
     int animationStep;
     bool arrowVisible;
 
     SingleImageState imageState = SingleImageState::TV;
 
+    std::mutex decodeMutex;
+    std::condition_variable decodeCondition;
+    std::thread decodeThread;
+    uint32_t decodeGeneration = 0;        // bumped for every pair, older decodes are dropped
+    std::string decodePaths[2];           // TV and DRC, empty once taken or when missing
+    SDL_Surface *decodedSurfaces[2] = {}; // waiting for their upload
+    bool probePending = false;            // the pair's metadata is not known yet
+    bool probeReady = false;              // probedInfo waits to be taken over
+    ImageInfo probedInfo[2] = {};
+    bool stopping = false;
+
     SDL_Rect arrowRect = {0, (SCREEN_HEIGHT / 2) - 145, 290, 290};
     SDL_Rect fullscreenTVRect;
     SDL_Rect fullscreenDRCRect;
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <ScreenshotFormat.h>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define IMAGE_PROBE_BUFFER_SIZE  (4 * 1024) // stdio buffer, the first read pulls in all the usual headers
+#define IMAGE_PROBE_MAX_SEGMENTS 32         // JPEG segments or PNG chunks looked at before giving up
+
+// What the headers say about an image. Zero width means it could not be read.
+struct ImageInfo {
+    uint64_t captureTime; // packed as in CaptureTime.h, EXIF or PNG tIME
+    uint32_t fileSize;
+    uint32_t width;
+    uint32_t height;
+    ImageFormat format;
+    uint8_t orientation; // EXIF orientation, 1 is upright
+};
+
+// Reads dimensions, format, orientation and timestamp from JPEG, PNG and BMP
+// headers. Only a few KB at the start of a file are read and pixels are never
+// decoded. One probe reuses its buffers across files, so batches should share
+// one.
+class ImageProbe {
+public:
+    ImageProbe();
+
+    bool probe(const std::string &path, ImageInfo &info);
+
+    // Orientation and capture time from a JPEG EXIF block already in memory
+    static bool parseExif(const uint8_t *data, size_t size, ImageInfo &info);
+
+private:
+    bool probeJPEG(FILE *file, ImageInfo &info);
+
+    bool probePNG(FILE *file, ImageInfo &info);
+
+    bool probeBMP(FILE *file, ImageInfo &info);
+
+    std::unique_ptr<char[]> streamBuffer;
+    std::vector<uint8_t> exifBuffer;
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <ImageProbe.h>
+#include <SlotMap.h>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define METADATA_PROBE_BATCH_SIZE      32 // pairs probed per lock of the queue
+#define METADATA_PROBE_THREAD_PRIORITY 20 // below the UI, so thumbnails stay ahead
+
+struct ProbeJob {
+    SlotHandle handle;
+    std::string pathTV; // empty for a missing half
+    std::string pathDRC;
+};
+
+struct ProbeResult {
+    SlotHandle handle;
+    ImageInfo tv;
+    ImageInfo drc;
+};
+
+// Probes the headers of whole folders on one background thread, in the order
+// the jobs were submitted, so the part of the grid shown first is known first
+class MetadataProber {
+public:
+    MetadataProber();
+
+    ~MetadataProber();
+
+    MetadataProber(const MetadataProber &) = delete;
+
+    MetadataProber &operator=(const MetadataProber &) = delete;
+
+    void submit(std::vector<ProbeJob> &&jobs);
+
+    // Hands over the results finished since the last call
+    void collect(std::vector<ProbeResult> &results);
+
+    // Drops queued jobs and discards whatever is being probed
+    void reset();
+
+    // Blocks until the batch being probed is done, so no file is open. Jobs
+    // still queued are left, call reset() first to drop them.
+    void waitUntilIdle();
+
+private:
+    void workerLoop();
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::condition_variable idle;
+    std::deque<ProbeJob> pending;
+    std::vector<ProbeResult> completed;
+    uint32_t epoch = 0;
+    bool probing = false;
+    bool stopping = false;
+    std::thread worker;
+};
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#define MUSIC_STREAM_RING_SIZE  (64 * 1024)
+#define MUSIC_STREAM_READ_CHUNK (16 * 1024)
+
+// Opens a file as an SDL_RWops that streams through a small read-ahead ring
+// buffer instead of keeping the whole file resident. Recently consumed bytes
+// stay in the ring, so the short backwards seeks decoders do while probing
+// headers don't hit the file again.
+SDL_RWops *openMusicStream(const char *path);
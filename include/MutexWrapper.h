@@ -1,25 +0,0 @@
-#pragma once
-
-#include <coreinit/cache.h>
-#include <coreinit/mutex.h>
-
-class MutexWrapper {
-public:
-    MutexWrapper() = default;
-
-    void init(const char *name) {
-        OSInitMutexEx(&mutex, name);
-    }
-
-    void lock() {
-        OSLockMutex(&mutex);
-    }
-
-    void unlock() {
-        OSUnlockMutex(&mutex);
-        OSMemoryBarrier();
-    }
-
-private:
-    OSMutex mutex{};
-};
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <ScreenshotFormat.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct PathStem {
+    uint32_t offset;
+    uint32_t length;
+};
+
+// Screenshot paths broken into parts that are each stored once in a single
+// string pool: a directory per folder, a stem per pair, and per file only
+// ids plus the kind and format that select its suffix. Full paths are
+// rebuilt when a file is actually opened.
+class PathTable {
+public:
+    // Directories are not deduplicated, callers add each one once
+    uint32_t addDirectory(std::string_view path);
+
+    // Both halves of a pair share one stem of at most
+    // SCREENSHOT_STEM_MAX_LENGTH characters
+    PathStem addStem(std::string_view stem);
+
+    uint32_t addFile(uint32_t directory, PathStem stem, ScreenshotKind kind, ImageFormat format);
+
+    // The id must not be used afterwards and goes to the next added file.
+    // Stems of removed files are dropped from the pool once they make up
+    // half of the table.
+    void remove(uint32_t file);
+
+    std::string_view getDirectory(uint32_t directory) const;
+
+    uint32_t getFileDirectory(uint32_t file) const {
+        return files[file].directory;
+    }
+
+    std::string_view getStem(uint32_t file) const;
+
+    ImageFormat getFormat(uint32_t file) const {
+        return files[file].format;
+    }
+
+    // After the file was converted, the path then ends in the new extension
+    void setFormat(uint32_t file, ImageFormat format) {
+        files[file].format = format;
+    }
+
+    // Files that share a directory and stem belong to the same pair
+    bool isSamePair(uint32_t a, uint32_t b) const {
+        return files[a].directory == files[b].directory && files[a].stemOffset == files[b].stemOffset;
+    }
+
+    void buildPath(uint32_t file, std::string &path) const;
+
+    void reserve(size_t fileCount, size_t poolBytes);
+
+    void clear();
+
+    size_t getMemoryUsage() const;
+
+private:
+    struct Directory {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    struct File {
+        uint32_t directory;
+        uint32_t stemOffset;
+        uint16_t stemLength;
+        ScreenshotKind kind;
+        ImageFormat format;
+    };
+
+    uint32_t append(std::string_view text);
+
+    void compact();
+
+    std::string pool;
+    std::vector<Directory> directories;
+    std::vector<File> files;
+    std::vector<uint32_t> freeFiles;
+    size_t removedFiles = 0;
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define PERCEPTUAL_HASH_WORKER_COUNT 3 // one per core, the UI only draws a progress line meanwhile
+#define PERCEPTUAL_HASH_BANDS        8 // 8-bit bands, see findSimilarClusters
+#define SIMILAR_MAX_DISTANCE         6 // differing bits of two burst shots of one scene
+
+// 64-bit difference hash plus a sharpness score, both taken from a
+// thumbnail. Hashes of near-identical images differ in only a few bits.
+struct PerceptualHash {
+    uint64_t bits;
+    uint32_t sharpness; // sum of luma gradients, higher is crisper
+};
+
+// Works on RGBA32 pixels at thumbnail size. The image is box-filtered down
+// to 9x8 luma cells; each bit says whether a cell is darker than its right
+// neighbour.
+PerceptualHash computePerceptualHash(const uint8_t *pixels, int width, int height, int pitch);
+
+inline int getHammingDistance(uint64_t a, uint64_t b) {
+    return __builtin_popcountll(a ^ b);
+}
+
+// Groups hashes that are within maxDistance bits of each other, directly or
+// through a chain of similar hashes. Only groups of two or more come back,
+// as indices into `hashes`. maxDistance must stay below
+// PERCEPTUAL_HASH_BANDS: then two close hashes always share one band
+// exactly, and only hashes sharing a band are ever compared.
+std::vector<std::vector<uint32_t>> findSimilarClusters(const std::vector<uint64_t> &hashes, int maxDistance);
+
+// Decodes each image at thumbnail size on PERCEPTUAL_HASH_WORKER_COUNT
+// threads and hashes it. Images that fail to decode get a zero sharpness
+// and `valid` false. `done` counts finished images for a progress display.
+void hashImages(const std::vector<std::string> &paths, int width, int height, std::vector<PerceptualHash> &hashes, std::vector<uint8_t> &valid, std::atomic<uint32_t> &done);
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+#define PNG_WRITER_CHUNK_SIZE (64 * 1024) // deflate output gathered per IDAT chunk
+#define PNG_WRITER_LEVEL      3           // screenshots barely shrink further past this, but encode much slower
+
+// Encodes an 8-bit RGB PNG from rows handed in top to bottom, so an image
+// taller than memory allows can be written a strip at a time. Rows use the
+// Up filter, which is a plain byte subtraction. The file is written under a
+// ".part" name and renamed by finish(); an abandoned writer removes it.
+class PngWriter {
+public:
+    ~PngWriter();
+
+    bool open(const std::string &path, uint32_t width, uint32_t height, int level = PNG_WRITER_LEVEL);
+
+    bool writeRows(const uint8_t *rows, uint32_t count, size_t pitch);
+
+    // Fails if fewer rows than the height were written
+    bool finish();
+
+private:
+    bool writeChunk(const char *type, const uint8_t *data, size_t size);
+
+    bool deflateInto(int flush);
+
+    void close();
+
+    FILE *file = nullptr;
+    z_stream stream{};
+    bool streamOpen = false;
+    bool failed = false;
+    std::string path;
+    std::string partPath;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t rowsWritten = 0;
+    std::vector<uint8_t> previousRow;
+    std::vector<uint8_t> filteredRow;
+    std::vector<uint8_t> output;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Progress counters shared between the scanner thread and the UI. Each counter
+// only ever grows and is read for display, so relaxed atomics are enough and
+// the UI never has to take a lock to draw the loading screen.
+class ScanProgress {
+public:
+    ScanProgress() = default;
+
+    ScanProgress(const ScanProgress &) = delete;
+
+    ScanProgress &operator=(const ScanProgress &) = delete;
+
+    void addFileSeen() {
+        filesSeen.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void addPairFound() {
+        pairsFound.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void addThumbnailDecoded() {
+        thumbnailsDecoded.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint32_t getFilesSeen() const {
+        return filesSeen.load(std::memory_order_relaxed);
+    }
+
+    uint32_t getPairsFound() const {
+        return pairsFound.load(std::memory_order_relaxed);
+    }
+
+    uint32_t getThumbnailsDecoded() const {
+        return thumbnailsDecoded.load(std::memory_order_relaxed);
+    }
+
+    void reset() {
+        filesSeen.store(0, std::memory_order_relaxed);
+        pairsFound.store(0, std::memory_order_relaxed);
+        thumbnailsDecoded.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint32_t> filesSeen{0};
+    std::atomic<uint32_t> pairsFound{0};
+    std::atomic<uint32_t> thumbnailsDecoded{0};
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+// Longest stem a path table can hold, longer names are not screenshots
+#define SCREENSHOT_STEM_MAX_LENGTH UINT16_MAX
+
+enum class ScreenshotKind : uint8_t {
+    None,
+    TV,
+    DRC,
+};
+
+enum class ImageFormat : uint8_t {
+    Unknown,
+    JPG,
+    PNG,
+    BMP,
+};
+
+const char *getImageFormatExtension(ImageFormat format);
+
+const char *getScreenshotKindSuffix(ScreenshotKind kind);
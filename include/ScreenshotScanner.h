@@ -0,0 +1,83 @@
+#pragma once
+
+#include <DirectoryEnumerator.h>
+#include <ScanProgress.h>
+#include <ScreenshotFormat.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#define PATH_ARENA_BLOCK_SIZE (64 * 1024)
+
+struct ScreenshotName {
+    ScreenshotKind kind;
+    ImageFormat format;
+    // Length of the shared part of the name, e.g. "2024-01-01_12-00-00" for
+    // both "2024-01-01_12-00-00_TV.jpg" and "2024-01-01_12-00-00_DRC.jpg"
+    uint32_t stemLength;
+};
+
+// Classifies a file name by walking its suffix backwards once.
+ScreenshotName classifyScreenshotName(std::string_view filename);
+
+// Bump allocator for the strings of one scan. Everything is released at once
+// when the arena is cleared, so per-entry strings never hit the heap.
+class PathArena {
+public:
+    std::string_view store(std::string_view text);
+
+    void clear();
+
+private:
+    std::vector<std::unique_ptr<char[]>> blocks;
+    size_t blockUsed = PATH_ARENA_BLOCK_SIZE;
+};
+
+struct ScreenshotPair {
+    uint32_t directory;
+    std::string_view stem;
+    ImageFormat tvFormat;  // Unknown when the pair has no TV image
+    ImageFormat drcFormat; // Unknown when the pair has no DRC image
+};
+
+class ScreenshotScanner : private DirectoryVisitor {
+public:
+    explicit ScreenshotScanner(ScanProgress *progress = nullptr);
+
+    // A scan that is not recursive only reports the files directly in rootPath
+    void scan(const std::string &rootPath, DirectoryBackend backend = DirectoryBackend::Posix, bool recursive = true);
+
+    void clear();
+
+    const std::vector<ScreenshotPair> &getPairs() const;
+
+    std::string_view getDirectory(uint32_t index) const;
+
+    std::string buildPath(const ScreenshotPair &pair, ScreenshotKind kind) const;
+
+private:
+    struct ScanRecord {
+        uint32_t directory;
+        ScreenshotKind kind;
+        ImageFormat format;
+        std::string_view stem;
+    };
+
+    bool onDirectory(std::string_view path) override;
+
+    void onFile(std::string_view name) override;
+
+    void pairRecords();
+
+    ScanProgress *progress;
+    PathArena arena;
+    std::vector<std::string_view> directories;
+    std::vector<ScanRecord> records;
+    std::unordered_set<std::string_view> directoryStems; // of the current directory, counts pairs as they turn up
+    std::vector<ScreenshotPair> pairs;
+    uint32_t currentDirectory = 0;
+    bool recursive = true;
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+
+#define SCROLL_VELOCITY_SAMPLES 8
+#define SCROLL_VELOCITY_WINDOW  100 // ms of touch history used for the fling velocity
+#define SCROLL_FRICTION         2.5f
+#define SCROLL_STOP_VELOCITY    15.0f // px/s below which a fling ends
+#define SCROLL_ANIMATION_RATE   12.0f
+
+// Vertical kinetic scrolling. Offsets are in pixels and added to content
+// coordinates to get screen coordinates, so scrolling down makes them negative.
+class ScrollEngine {
+public:
+    void setBounds(float minOffset, float maxOffset);
+
+    void touchDown(float y, uint32_t timestamp);
+
+    void touchMove(float y, uint32_t timestamp);
+
+    void touchUp(uint32_t timestamp);
+
+    // Smoothly animates to an offset, used for controller navigation
+    void scrollTo(float target);
+
+    // Moves to an offset at once, for when the content is replaced
+    void jumpTo(float target);
+
+    // Scrolls just enough for [contentTop, contentBottom] to fit the viewport
+    void ensureVisible(float contentTop, float contentBottom, float viewportTop, float viewportBottom);
+
+    void stop();
+
+    void update(float deltaSeconds);
+
+    float getOffset() const;
+
+    float getMinOffset() const;
+
+    float getVelocity() const;
+
+    // Velocity and offset `seconds` from now if nothing interrupts the current
+    // motion, so loaders can prefetch ahead of where the list is going
+    float getPredictedVelocity(float seconds) const;
+
+    float getPredictedOffset(float seconds) const;
+
+    float getDragDistance() const;
+
+    bool isDragging() const;
+
+    bool isMoving() const;
+
+private:
+    enum class Mode {
+        Idle,
+        Dragging,
+        Flinging,
+        Animating,
+    };
+
+    struct Sample {
+        float y;
+        uint32_t timestamp;
+    };
+
+    float clampOffset(float value) const;
+
+    float estimateVelocity(uint32_t now) const;
+
+    Mode mode = Mode::Idle;
+    float offset = 0.0f;
+    float minOffset = 0.0f;
+    float maxOffset = 0.0f;
+    float velocity = 0.0f;
+    float targetOffset = 0.0f;
+    float lastTouchY = 0.0f;
+    float dragDistance = 0.0f;
+    Sample samples[SCROLL_VELOCITY_SAMPLES]{};
+    int sampleCount = 0;
+    int sampleHead = 0;
+};
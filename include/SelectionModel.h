@@ -0,0 +1,61 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Dense bitset over grid indices. The number of selected entries is kept up
+// to date with popcounts as words change, so "is anything selected" is free
+// and bulk operations touch one word per 64 entries.
+class SelectionModel {
+public:
+    // Drops the current selection
+    void resize(size_t size);
+
+    size_t size() const {
+        return bitCount;
+    }
+
+    size_t count() const {
+        return selectedCount;
+    }
+
+    bool any() const {
+        return selectedCount != 0;
+    }
+
+    bool isSelected(size_t index) const {
+        return (words[index / 64] >> (index % 64)) & 1;
+    }
+
+    void set(size_t index, bool selected);
+
+    void toggle(size_t index);
+
+    // Inclusive range, in either order
+    void setRange(size_t first, size_t last, bool selected);
+
+    bool isRangeSelected(size_t first, size_t last) const;
+
+    void selectAll();
+
+    void clear();
+
+    // Calls function(index) for every selected entry in ascending order
+    template<typename Function>
+    void forEachSelected(Function function) const {
+        for (size_t word = 0; word < words.size(); word++) {
+            uint64_t bits = words[word];
+            while (bits) {
+                function(word * 64 + std::countr_zero(bits));
+                bits &= bits - 1;
+            }
+        }
+    }
+
+private:
+    std::vector<uint64_t> words;
+    size_t bitCount = 0;
+    size_t selectedCount = 0;
+};
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define SLIDESHOW_DECODE_AHEAD     3    // slides decoded past the one in view
+#define SLIDESHOW_WORKER_COUNT     2
+#define SLIDESHOW_THREAD_PRIORITY  18   // above the header probes, the next slide is due soon
+#define SLIDESHOW_INTERVAL_MS      5000
+#define SLIDESHOW_FADE_MS          800
+
+struct SlideSource {
+    std::string path;
+    uint8_t orientation; // EXIF orientation, 1 if unknown
+};
+
+// Shows images one after another, looping, with a crossfade between them.
+// Workers decode the next few slides at full resolution while the current one
+// is shown; a slide only comes up once its texture is resident, so a slow
+// decode holds the current slide longer instead of showing a placeholder.
+// Slides are numbered in showing order and wrap around the sources, so
+// stepping back before the first one works as well.
+class Slideshow {
+public:
+    Slideshow(SDL_Renderer *renderer, std::vector<SlideSource> sources, uint32_t first);
+
+    ~Slideshow();
+
+    Slideshow(const Slideshow &) = delete;
+
+    Slideshow &operator=(const Slideshow &) = delete;
+
+    // Uploads at most one decoded slide and advances when the next one is due
+    // and resident
+    void update(Uint32 now);
+
+    void render(Uint32 now);
+
+    // Moves on right away, or as soon as that slide is decoded
+    void step(int direction);
+
+    void togglePaused();
+
+    bool isPaused() const {
+        return paused;
+    }
+
+    // Whether the slide due next is still being decoded
+    bool isWaiting(Uint32 now) const;
+
+    uint32_t getCurrentSource() const {
+        return getSource(current);
+    }
+
+private:
+    enum class SlideState : uint8_t {
+        Queued,
+        Decoding,
+        Decoded,
+        Resident,
+        Failed,
+    };
+
+    struct Slide {
+        int64_t number;
+        SlideState state;
+        SDL_Surface *surface;
+        SDL_Texture *texture;
+    };
+
+    uint32_t getSource(int64_t number) const;
+
+    // Slide of the given number, nullptr outside the window; the mutex is held
+    Slide *findSlide(int64_t number);
+
+    bool isInWindow(int64_t number) const;
+
+    // Keeps the outgoing slide, the current one and the next ones in the
+    // window, queueing new ones and dropping the rest. Failed slides do not
+    // count towards the ones ahead, and the window never spans a source twice.
+    void updateWindow();
+
+    void renderSlide(const Slide *slide, uint8_t alpha);
+
+    void workerLoop();
+
+    SDL_Renderer *renderer;
+    std::vector<SlideSource> sources;
+    std::vector<Slide> slides; // the window, plus slides still decoding that fell out of it
+    int64_t current;
+    int64_t previous;         // fading out, equal to current when no fade runs
+    int direction = 1;        // of the next advance
+    int64_t windowAhead = 0;  // slides past the current one in the window
+    bool exhausted = false;   // every slide ahead failed, there is nothing to advance to
+    bool windowStale = false; // a slide failed since the window was last laid out
+    bool stepRequested = false;
+    bool paused = false;
+    Uint32 slideStart = 0;
+    Uint32 fadeStart = 0;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#define SLOT_MAP_NO_SLOT UINT32_MAX
+
+// Refers to a slot map entry. The generation changes whenever the slot is
+// freed, so a handle to a removed entry never resolves to whatever reuses
+// its slot.
+struct SlotHandle {
+    uint32_t index = SLOT_MAP_NO_SLOT;
+    uint32_t generation = 0;
+
+    bool operator==(const SlotHandle &other) const {
+        return index == other.index && generation == other.generation;
+    }
+};
+
+// Storage with O(1) insert and erase whose handles stay valid across other
+// inserts and erases. Freed slots are chained into a free list and reused.
+// Pointers returned by get() are only valid until the next insert.
+template<typename T>
+class SlotMap {
+public:
+    SlotHandle insert(T value) {
+        uint32_t index;
+        if (freeHead != SLOT_MAP_NO_SLOT) {
+            index = freeHead;
+            freeHead = slots[index].nextFree;
+            slots[index].value = std::move(value);
+        } else {
+            index = static_cast<uint32_t>(slots.size());
+            slots.push_back({std::move(value), 0, SLOT_MAP_NO_SLOT, false});
+        }
+        slots[index].occupied = true;
+        count++;
+        return {index, slots[index].generation};
+    }
+
+    bool erase(SlotHandle handle) {
+        if (!contains(handle)) {
+            return false;
+        }
+        Slot &slot = slots[handle.index];
+        slot.value = T();
+        slot.occupied = false;
+        slot.generation++;
+        slot.nextFree = freeHead;
+        freeHead = handle.index;
+        count--;
+        return true;
+    }
+
+    bool contains(SlotHandle handle) const {
+        return handle.index < slots.size() && slots[handle.index].occupied && slots[handle.index].generation == handle.generation;
+    }
+
+    // Returns nullptr for stale handles
+    T *get(SlotHandle handle) {
+        return contains(handle) ? &slots[handle.index].value : nullptr;
+    }
+
+    const T *get(SlotHandle handle) const {
+        return contains(handle) ? &slots[handle.index].value : nullptr;
+    }
+
+    // The handle must be valid
+    T &operator[](SlotHandle handle) {
+        return slots[handle.index].value;
+    }
+
+    const T &operator[](SlotHandle handle) const {
+        return slots[handle.index].value;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    // Upper bound on handle indices, for arrays kept alongside the map
+    size_t capacity() const {
+        return slots.size();
+    }
+
+    void reserve(size_t capacity) {
+        slots.reserve(capacity);
+    }
+
+    void clear() {
+        for (uint32_t i = 0; i < slots.size(); i++) {
+            if (slots[i].occupied) {
+                erase({i, slots[i].generation});
+            }
+        }
+    }
+
+private:
+    struct Slot {
+        T value;
+        uint32_t generation;
+        uint32_t nextFree;
+        bool occupied;
+    };
+
+    std::vector<Slot> slots;
+    uint32_t freeHead = SLOT_MAP_NO_SLOT;
+    size_t count = 0;
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+enum class SortMode : uint8_t {
+    NewestFirst,
+    OldestFirst,
+    ByGame,
+    Count,
+};
+
+// Precomputed integer key of one grid position. Ties fall back to `tie`, so
+// equal keys still come out in the same order on every launch.
+struct SortKey {
+    uint64_t key;
+    uint32_t tie;
+    uint32_t position; // where the item was before sorting
+};
+
+const char *getSortModeName(SortMode mode);
+
+SortMode getNextSortMode(SortMode mode);
+
+// Ascending key for a capture time under a chronological mode. Unknown
+// times sort last either way.
+uint64_t makeCaptureSortKey(uint64_t captureTime, SortMode mode);
+
+void sortByKeys(std::vector<SortKey> &keys);
+
+// Rearranges items into the order of sorted keys
+template<typename T>
+void applySortOrder(std::vector<T> &items, const std::vector<SortKey> &keys) {
+    std::vector<T> sorted;
+    sorted.reserve(items.size());
+    for (const auto &key : keys) {
+        sorted.push_back(items[key.position]);
+    }
+    items = std::move(sorted);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <ScreenshotScanner.h>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define OPTIMIZE_JPEG_QUALITY  92
+#define OPTIMIZE_PNG_LEVEL     6 // zlib's default, lossless runs are rare enough to afford it
+#define OPTIMIZE_WORKER_COUNT  3
+#define OPTIMIZE_TEMP_SUFFIX   ".opt"
+#define OPTIMIZE_BACKUP_SUFFIX ".old"
+
+enum class OptimizeMode : uint8_t {
+    Jpeg,     // PNG and BMP become JPEG
+    Lossless, // PNG and BMP become recompressed PNG
+};
+
+// Paths empty for a missing half
+struct OptimizeJob {
+    std::string pathTV;
+    std::string pathDRC;
+};
+
+struct OptimizeResult {
+    ImageFormat tvFormat; // what each half is now, Unknown if missing
+    ImageFormat drcFormat;
+    bool optimized;
+};
+
+// Written by the workers, read by the UI. Setting `cancelled` stops after
+// the pairs in flight, which are either fully converted or untouched.
+struct OptimizeProgress {
+    std::atomic<uint32_t> pairsDone{0};
+    std::atomic<uint32_t> pairsFailed{0};
+    std::atomic<uint64_t> bytesRead{0};    // originals of the pairs converted
+    std::atomic<uint64_t> bytesWritten{0}; // and what replaced them
+    std::atomic<bool> cancelled{false};
+};
+
+// Whether a half in this format would be converted at all
+bool isOptimizable(ImageFormat format);
+
+// Re-encodes the PNG and BMP halves of each pair on a worker pool. Both
+// halves are encoded to temporary files first and only swapped in together,
+// and only if the pair got smaller, so a pair never ends up half converted.
+// Pixels are kept as RGB, alpha is dropped.
+void optimizePairs(const std::vector<OptimizeJob> &jobs, OptimizeMode mode, std::vector<OptimizeResult> &results, OptimizeProgress &progress);
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <vector>
+
+// Fixed set of same-sized streaming textures created up front. Thumbnails
+// are written into free slots and hand them back on eviction, so scrolling
+// never creates or destroys textures. Slots are small integers so image
+// records can refer to them compactly.
+class TexturePool {
+public:
+    TexturePool(SDL_Renderer *renderer, int width, int height, int capacity);
+
+    ~TexturePool();
+
+    TexturePool(const TexturePool &) = delete;
+
+    TexturePool &operator=(const TexturePool &) = delete;
+
+    // Returns -1 when every slot is in use
+    int acquire();
+
+    void release(int slot);
+
+    SDL_Texture *getTexture(int slot) const;
+
+    // The surface must be RGBA32 and exactly the pool's size
+    bool upload(int slot, SDL_Surface *surface);
+
+    size_t getAvailable() const;
+
+private:
+    int width;
+    int height;
+    std::vector<SDL_Texture *> textures;
+    std::vector<uint16_t> freeList;
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <ThumbnailScheduler.h>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#define UPLOAD_FRAME_TARGET_US 16667
+#define UPLOAD_SAFETY_US       2500 // headroom left for present and timing noise
+#define UPLOAD_MIN_US          500
+#define UPLOAD_MAX_BYTES       (2 * 1024 * 1024)
+
+// Spreads texture uploads over frames. Each frame gets whatever is left of
+// the 60 fps budget after the rest of the frame's work, estimated from
+// recent frames, and backs off further after a frame overruns.
+class TextureUploadQueue {
+public:
+    // Returns the urgency of an index, lower first, or a negative value when
+    // its upload is no longer wanted
+    using PriorityFunction = std::function<float(uint32_t index)>;
+
+    using UploadFunction = std::function<void(const ThumbnailResult &result)>;
+
+    ~TextureUploadQueue();
+
+    void push(const ThumbnailResult &result);
+
+    // Marks the start of a frame, before events are processed
+    void beginFrame();
+
+    // Marks the end of the frame's own work, right before presenting
+    void endFrame();
+
+    // Uploads as much as the current budget allows, most urgent first. At
+    // least one item goes through every frame so the queue always drains.
+    // The upload function takes ownership of the surfaces.
+    int process(const PriorityFunction &priority, const UploadFunction &upload);
+
+    void clear();
+
+    bool isPending(uint32_t index) const {
+        return index < queued.size() && queued[index];
+    }
+
+    size_t size() const;
+
+    uint32_t getBudgetMicros() const;
+
+private:
+    uint64_t elapsedMicros(uint64_t since) const;
+
+    std::vector<ThumbnailResult> pending;
+    std::vector<std::pair<float, size_t>> order;
+    // Indexed by result index, set while a result for it waits here
+    std::vector<uint8_t> queued;
+    uint64_t frameStart = 0;
+    uint64_t uploadMicros = 0;
+    float frameWorkEstimate = 8000.0f;
+    float backoff = 1.0f;
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <PerceptualHash.h>
+#include <SDL2/SDL.h>
+#include <ScanProgress.h>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#define THUMBNAIL_WORKER_COUNT    2
+#define THUMBNAIL_PREFETCH_AHEAD  3 // rows prefetched in the direction of travel
+#define THUMBNAIL_PREFETCH_BEHIND 1
+#define THUMBNAIL_PREDICT_SECONDS 0.3f
+#define THUMBNAIL_EVICT_MARGIN    2 // rows kept resident beyond the prefetch window
+
+// Rows of the grid that are on screen now, and the wider window worth
+// decoding given where the scroll is heading
+struct ThumbnailViewport {
+    int firstVisibleRow;
+    int lastVisibleRow;
+    int firstPrefetchRow;
+    int lastPrefetchRow;
+    int direction; // +1 scrolling towards later rows, -1 towards earlier ones
+};
+
+// Takes the screen position of row 0 now and at the predicted scroll offset,
+// which keeps this independent of how the grid is laid out
+ThumbnailViewport computeThumbnailViewport(float rowZeroTop, float predictedRowZeroTop, float rowPitch, float tileHeight, float viewportTop, float viewportBottom, int rowCount, float velocity);
+
+// Lower is more urgent. Visible rows always rank ahead of prefetch rows, and
+// rows ahead of the scroll direction rank ahead of rows behind it.
+float getThumbnailPriority(int row, const ThumbnailViewport &viewport);
+
+// Decodes an image and stretches it to exactly width x height RGBA32
+SDL_Surface *decodeThumbnail(const std::string &path, int width, int height);
+
+struct ThumbnailRequest {
+    uint32_t index;
+    float priority;
+};
+
+struct ThumbnailResult {
+    uint32_t index;
+    SDL_Surface *surfaceTV;
+    SDL_Surface *surfaceDRC;
+    PerceptualHash hash; // of the TV half, or the DRC half of a pair without one
+    bool hashed;
+};
+
+class ThumbnailScheduler {
+public:
+    using PathProvider = std::function<void(uint32_t index, std::string &pathTV, std::string &pathDRC)>;
+
+    ThumbnailScheduler(int width, int height, ScanProgress *progress);
+
+    ~ThumbnailScheduler();
+
+    ThumbnailScheduler(const ThumbnailScheduler &) = delete;
+
+    ThumbnailScheduler &operator=(const ThumbnailScheduler &) = delete;
+
+    // Replaces the set of wanted thumbnails. Queued jobs missing from
+    // `requests` are cancelled before they start; paths are only looked up
+    // for indices that are not queued, running or waiting to be collected.
+    void schedule(const std::vector<ThumbnailRequest> &requests, const PathProvider &paths);
+
+    // Hands finished thumbnails to the caller, who owns the surfaces
+    void collect(std::vector<ThumbnailResult> &results);
+
+    // Drops all queued work and discards anything still running, for when
+    // indices stop meaning what they did (deletes, reordering)
+    void reset();
+
+    // Blocks until no decode is running, so no file is open. Jobs still
+    // queued are left, call reset() first to drop them.
+    void waitUntilIdle();
+
+private:
+    struct Job {
+        uint32_t index;
+        float priority;
+        std::string pathTV;
+        std::string pathDRC;
+    };
+
+    void workerLoop();
+
+    int width;
+    int height;
+    ScanProgress *progress;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::condition_variable idle;
+    std::vector<Job> pending;
+    std::vector<ThumbnailResult> completed;
+    std::unordered_set<uint32_t> active; // queued, running or completed
+    uint32_t epoch = 0;
+    int running = 0;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define TRASH_DIRECTORY_NAME         ".trash"
+#define TRASH_PURGE_THREAD_PRIORITY  30 // close to the lowest, 31
+
+// Deleting moves files into a hidden directory on the same volume, which is
+// a single rename per file. The last batch can be moved back; older batches,
+// and anything left over from previous runs, are deleted for real by a
+// low-priority thread while the app reports itself idle.
+class TrashBin {
+public:
+    explicit TrashBin(const std::string &rootPath);
+
+    ~TrashBin();
+
+    TrashBin(const TrashBin &) = delete;
+
+    TrashBin &operator=(const TrashBin &) = delete;
+
+    // Starts a new undoable batch. The previous batch can no longer be
+    // restored and is handed to the purger.
+    void beginBatch();
+
+    // Moves all files or none of them into the trash, as part of the current
+    // batch. Files that belong together, like both halves of a screenshot
+    // pair, are passed in one call.
+    bool moveToTrash(const std::vector<std::string> &paths);
+
+    bool canUndo() const;
+
+    // Moves the current batch back to where it came from. The files of one
+    // moveToTrash call come back together or not at all; `restored` gets the
+    // indices of the calls that came back, counted within the batch. What
+    // could not be restored stays in the batch, renumbered in order, so the
+    // undo can be tried again. Returns false if anything was left.
+    bool undoLastBatch(std::vector<uint32_t> &restored);
+
+    // The purger only deletes while idle, so it never competes with input
+    // handling or thumbnail decoding for the SD card
+    void setIdle(bool idle);
+
+private:
+    struct TrashedFile {
+        std::string originalPath;
+        std::string trashPath;
+        uint32_t group; // moveToTrash call within the batch
+    };
+
+    void purgeLoop();
+
+    std::string trashPath;
+    std::string namePrefix;
+    uint32_t nameCounter = 0;
+    std::vector<TrashedFile> lastBatch;
+    uint32_t groupCount = 0;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<std::string> purgeable;
+    bool idle = false;
+    bool stopping = false;
+    std::thread purger;
+};
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <FileExporter.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define ZIP_OUTPUT_BUFFER_SIZE (64 * 1024)  // gathers headers between blocks
+#define ZIP_MAX_ENTRIES        0xFFFF       // no ZIP64, so 16-bit counts
+#define ZIP_MAX_OFFSET         0xFFFFFFFFu  // and 32-bit sizes and offsets, which FAT32 cannot exceed anyway
+
+struct ZipEntrySource {
+    std::string path;
+    std::string name;     // inside the archive, UTF-8
+    uint64_t captureTime; // packed as in CaptureTime.h, stored as the DOS time
+};
+
+// Writes the files into one store-only ZIP in a single pass. Data streams
+// through a BlockPipeline and the CRC is updated per block, then patched into
+// the local header with the size, so no file is read twice or held in memory
+// and streaming readers find every entry's size up front. The central
+// directory goes at the end. A file that fails to read is cut off again and
+// counted as failed. The archive is written under a ".part" name and renamed
+// when complete; on cancel or a write error nothing is left behind. Returns
+// true if every file was archived.
+bool writeZipArchive(const std::vector<ZipEntrySource> &entries, const std::string &zipPath, ExportProgress &progress);
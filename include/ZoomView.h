@@ -0,0 +1,132 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#define ZOOM_TILE_SIZE         256
+#define ZOOM_TILE_CACHE_SIZE   64      // resident tile textures, 16 MB at most
+#define ZOOM_UPLOADS_PER_FRAME 2       // keeps a fast pan from stalling a frame
+#define ZOOM_MAX_SCALE         8.0f    // screen pixels per image pixel
+#define ZOOM_STICK_SPEED       2.0f    // doublings of the scale per second at full tilt
+#define ZOOM_PAN_SPEED         1500.0f // screen pixels per second at full tilt
+#define ZOOM_PINCH_SPEED       4.0f    // scale change per unit of pinch distance
+#define ZOOM_STICK_DEADZONE    8000
+
+// Zoom and pan over one image. Full resolution is always drawn straight
+// from the image's texture, cut to the part on screen, so an image no
+// larger than the screen needs nothing else. A larger one also gets a mip
+// pyramid, built from its decoded pixels on a thread of its own when
+// zooming starts, so it is never drawn shrunk by more than half. Only the
+// tiles of the level that matches the scale and intersect the screen are
+// uploaded, a few per frame, into a fixed number of textures reused least
+// recently used first. Missing tiles are covered by the nearest coarser
+// tile that is resident and by the whole image at its coarsest level.
+// Levels between the one the fitted view uses and the coarsest are never
+// drawn and not kept.
+class ZoomView {
+public:
+    explicit ZoomView(SDL_Renderer *renderer);
+
+    ~ZoomView();
+
+    ZoomView(const ZoomView &) = delete;
+
+    ZoomView &operator=(const ZoomView &) = delete;
+
+    // Whether an image is at least twice the screen, and so is drawn from
+    // downscaled levels when fitted
+    static bool needsLevels(int width, int height);
+
+    // `fullTexture` is the whole image at full resolution. `pixels` are its
+    // decoded RGBA32 pixels, read by the pyramid build, and only needed when
+    // `needsLevels` holds.
+    void setImage(SDL_Texture *fullTexture, std::shared_ptr<SDL_Surface> pixels);
+
+    // Back to the fitted view, tiles and pyramid are dropped
+    void clear();
+
+    // Right stick zooms, left stick and touch drags pan, pinches zoom
+    void handleEvent(const SDL_Event &event);
+
+    void update(float seconds);
+
+    void render();
+
+    bool isZoomed() const {
+        return scale > fitScale * 1.001f;
+    }
+
+private:
+    struct Level {
+        int width;
+        int height;
+        std::vector<uint32_t> pixels; // RGBA32
+    };
+
+    struct Tile {
+        int level;
+        int column;
+        int row;
+        SDL_Texture *texture;
+        uint32_t lastUsed; // frame
+    };
+
+    // One decode and the pyramid made from it. A cancelled build keeps
+    // running until its decode returns, so it owns everything it touches.
+    struct Build {
+        std::vector<Level> levels;
+        std::atomic<bool> built{false};
+        std::atomic<bool> cancelled{false};
+        std::atomic<bool> finished{false}; // the thread can be joined without waiting
+        std::thread thread;
+    };
+
+    void startBuilding();
+
+    // Keeps the pixels of levels 1 to `detailLevels` - 1 and of the coarsest,
+    // level 0 is the full texture
+    static void buildPyramid(Build *build, std::shared_ptr<SDL_Surface> pixels, int detailLevels);
+
+    // Joins cancelled builds that have finished
+    void reapBuilds();
+
+    // Scales by `factor` keeping the image point under the screen point in place
+    void zoomAt(float factor, float screenX, float screenY);
+
+    void clampView();
+
+    int getLevel() const;
+
+    Tile *findTile(int level, int column, int row);
+
+    // Uploads a tile into a free or least recently used texture
+    Tile *uploadTile(int level, int column, int row);
+
+    // Draws the part of a tile that falls inside `area`, an image-space rect
+    void drawTile(const Tile &tile, const SDL_FRect &area);
+
+    // Draws the part of the full texture inside `view`, an image-space rect
+    void drawFullTexture(const SDL_FRect &view);
+
+    SDL_Renderer *renderer;
+    SDL_Texture *fullTexture = nullptr;
+    std::shared_ptr<SDL_Surface> pixels;
+    int imageWidth = 0;
+    int imageHeight = 0;
+    float fitScale = 1.0f;
+    float scale = 1.0f;
+    float centerX = 0.0f; // image point at the middle of the screen
+    float centerY = 0.0f;
+    int16_t axes[4] = {0, 0, 0, 0};
+    bool dragging = false;
+    uint32_t frame = 0;
+    int detailLevels = 1; // full resolution down to the level of the fitted view
+
+    std::unique_ptr<Build> build;
+    std::vector<std::unique_ptr<Build>> retired; // cancelled, still decoding
+    std::vector<Tile> tiles;
+};
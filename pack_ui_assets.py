@@ -0,0 +1,184 @@
+import os.path
+import struct
+import sys
+import zlib
+
+# Layout shared with include/AssetPack.h
+PACK_MAGIC = b"UIPK"
+PACK_VERSION = 1
+PACK_NAME_LENGTH = 32
+PACK_ALIGNMENT = 64
+ENCODING_RAW = 0
+ENCODING_RLE = 1
+HEADER_FORMAT = "<4sIII"
+ENTRY_FORMAT = "<32sIIIIII"
+
+
+def paeth(a, b, c):
+    p = a + b - c
+    pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+    if pa <= pb and pa <= pc:
+        return a
+    return b if pb <= pc else c
+
+
+def unfilter(data, width, height, bpp):
+    stride = width * bpp
+    out = bytearray(stride * height)
+    prev = bytearray(stride)
+    pos = 0
+    for y in range(height):
+        filter_type = data[pos]
+        line = bytearray(data[pos + 1:pos + 1 + stride])
+        pos += stride + 1
+        if filter_type == 1:
+            for i in range(bpp, stride):
+                line[i] = (line[i] + line[i - bpp]) & 0xFF
+        elif filter_type == 2:
+            for i in range(stride):
+                line[i] = (line[i] + prev[i]) & 0xFF
+        elif filter_type == 3:
+            for i in range(stride):
+                left = line[i - bpp] if i >= bpp else 0
+                line[i] = (line[i] + ((left + prev[i]) >> 1)) & 0xFF
+        elif filter_type == 4:
+            for i in range(stride):
+                left = line[i - bpp] if i >= bpp else 0
+                up_left = prev[i - bpp] if i >= bpp else 0
+                line[i] = (line[i] + paeth(left, prev[i], up_left)) & 0xFF
+        elif filter_type != 0:
+            raise ValueError(f"unknown PNG filter {filter_type}")
+        out[y * stride:(y + 1) * stride] = line
+        prev = line
+    return out
+
+
+def decode_png(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:8] != b"\x89PNG\r\n\x1a\n":
+        raise ValueError(f"{path} is not a PNG file")
+
+    pos = 8
+    idat = bytearray()
+    palette = None
+    transparency = None
+    while pos < len(data):
+        length, chunk_type = struct.unpack(">I4s", data[pos:pos + 8])
+        body = data[pos + 8:pos + 8 + length]
+        pos += length + 12
+        if chunk_type == b"IHDR":
+            width, height, depth, color_type, _, _, interlace = struct.unpack(">IIBBBBB", body)
+        elif chunk_type == b"PLTE":
+            palette = body
+        elif chunk_type == b"tRNS":
+            transparency = body
+        elif chunk_type == b"IDAT":
+            idat += body
+        elif chunk_type == b"IEND":
+            break
+
+    if depth != 8 or interlace != 0:
+        raise ValueError(f"{path}: only 8-bit non-interlaced PNGs are supported")
+
+    bpp = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}[color_type]
+    pixels = unfilter(zlib.decompress(bytes(idat)), width, height, bpp)
+
+    rgba = bytearray(width * height * 4)
+    if color_type == 6:
+        rgba[:] = pixels
+    elif color_type == 4:
+        rgba[0::4] = pixels[0::2]
+        rgba[1::4] = pixels[0::2]
+        rgba[2::4] = pixels[0::2]
+        rgba[3::4] = pixels[1::2]
+    elif color_type == 2:
+        rgba[0::4] = pixels[0::3]
+        rgba[1::4] = pixels[1::3]
+        rgba[2::4] = pixels[2::3]
+        rgba[3::4] = b"\xff" * (width * height)
+    elif color_type == 0:
+        rgba[0::4] = pixels
+        rgba[1::4] = pixels
+        rgba[2::4] = pixels
+        rgba[3::4] = b"\xff" * (width * height)
+    else:
+        for i, index in enumerate(pixels):
+            alpha = transparency[index] if transparency and index < len(transparency) else 0xFF
+            rgba[i * 4:i * 4 + 4] = palette[index * 3:index * 3 + 3] + bytes([alpha])
+    return width, height, bytes(rgba)
+
+
+def encode_rle(rgba):
+    # Control byte n: n & 0x80 -> (n & 0x7F) + 1 copies of the next pixel,
+    # otherwise n + 1 literal pixels follow.
+    out = bytearray()
+    count = len(rgba) // 4
+    i = 0
+    literal_start = 0
+    while i < count:
+        pixel = rgba[i * 4:i * 4 + 4]
+        run = 1
+        while i + run < count and run < 128 and rgba[(i + run) * 4:(i + run) * 4 + 4] == pixel:
+            run += 1
+        if run >= 3:
+            while literal_start < i:
+                n = min(128, i - literal_start)
+                out.append(n - 1)
+                out += rgba[literal_start * 4:(literal_start + n) * 4]
+                literal_start += n
+            out.append(0x80 | (run - 1))
+            out += pixel
+            i += run
+            literal_start = i
+        else:
+            i += run
+    while literal_start < count:
+        n = min(128, count - literal_start)
+        out.append(n - 1)
+        out += rgba[literal_start * 4:(literal_start + n) * 4]
+        literal_start += n
+    return bytes(out)
+
+
+def align(value):
+    return (value + PACK_ALIGNMENT - 1) & ~(PACK_ALIGNMENT - 1)
+
+
+def pack_assets(input_dir, output_path):
+    names = sorted(f for f in os.listdir(input_dir) if f.endswith(".png"))
+    entries = []
+    for name in names:
+        width, height, rgba = decode_png(os.path.join(input_dir, name))
+        rle = encode_rle(rgba)
+        # RLE only pays off for flat UI art; photographic assets stay raw.
+        if len(rle) * 2 <= len(rgba):
+            entries.append((name[:-4], width, height, ENCODING_RLE, rle))
+        else:
+            entries.append((name[:-4], width, height, ENCODING_RAW, rgba))
+
+    offset = align(struct.calcsize(HEADER_FORMAT) + struct.calcsize(ENTRY_FORMAT) * len(entries))
+    index = bytearray(struct.pack(HEADER_FORMAT, PACK_MAGIC, PACK_VERSION, len(entries), 0))
+    blobs = bytearray()
+    for name, width, height, encoding, blob in entries:
+        encoded_name = name.encode("utf-8")
+        if len(encoded_name) >= PACK_NAME_LENGTH:
+            raise ValueError(f"asset name {name} is too long")
+        index += struct.pack(ENTRY_FORMAT, encoded_name, width, height, offset + len(blobs), len(blob), encoding, 0)
+        blobs += blob
+        blobs += b"\0" * (align(len(blobs)) - len(blobs))
+
+    with open(output_path, "wb") as f:
+        f.write(index)
+        f.write(b"\0" * (align(len(index)) - len(index)))
+        f.write(blobs)
+
+    for name, width, height, encoding, blob in entries:
+        print(f"{name}: {width}x{height} {'rle' if encoding == ENCODING_RLE else 'raw'} {len(blob)} bytes")
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 3:
+        print(f"usage: {sys.argv[0]} <png directory> <output pack>")
+        sys.exit(1)
+    pack_assets(sys.argv[1], sys.argv[2])
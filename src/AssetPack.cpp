@@ -0,0 +1,170 @@
+#include <AssetPack.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/stat.h>
+#include <vector>
+#ifndef __WIIU__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+static void decodeRLE(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t pixelCount) {
+    const uint8_t *srcEnd = src + srcSize;
+    size_t written = 0;
+    while (src < srcEnd && written < pixelCount) {
+        uint8_t control = *src++;
+        size_t count = (control & 0x7F) + 1;
+        if (count > pixelCount - written) {
+            count = pixelCount - written;
+        }
+        if (control & 0x80) {
+            if (srcEnd - src < 4) {
+                break;
+            }
+            for (size_t i = 0; i < count; i++) {
+                memcpy(dst + (written + i) * 4, src, 4);
+            }
+            src += 4;
+        } else {
+            if (static_cast<size_t>(srcEnd - src) < count * 4) {
+                break;
+            }
+            memcpy(dst + written * 4, src, count * 4);
+            src += count * 4;
+        }
+        written += count;
+    }
+}
+
+AssetPack::~AssetPack() {
+    close();
+}
+
+bool AssetPack::open(const char *path) {
+    close();
+
+#ifdef __WIIU__
+    FILE *file = fopen(path, "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    struct stat st {};
+    if (fstat(fileno(file), &st) != 0 || st.st_size < static_cast<off_t>(sizeof(AssetPackHeader))) {
+        fclose(file);
+        return false;
+    }
+    size = st.st_size;
+    // One sequential read of the whole pack, no stdio buffering in between
+    setvbuf(file, nullptr, _IONBF, 0);
+    data = static_cast<uint8_t *>(aligned_alloc(64, (size + 63) & ~static_cast<size_t>(63)));
+    if (data == nullptr || fread(data, size, 1, file) != 1) {
+        fclose(file);
+        close();
+        return false;
+    }
+    fclose(file);
+#else
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(AssetPackHeader))) {
+        ::close(fd);
+        return false;
+    }
+    void *map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    data = static_cast<uint8_t *>(map);
+    size = st.st_size;
+    mapped = true;
+#endif
+
+    AssetPackHeader header;
+    memcpy(&header, data, sizeof(header));
+    entryCount = SDL_SwapLE32(header.entryCount);
+    if (SDL_SwapLE32(header.magic) != ASSET_PACK_MAGIC || SDL_SwapLE32(header.version) != ASSET_PACK_VERSION ||
+        sizeof(AssetPackHeader) + static_cast<size_t>(entryCount) * sizeof(AssetPackEntry) > size) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void AssetPack::close() {
+    if (data) {
+#ifndef __WIIU__
+        if (mapped) {
+            munmap(data, size);
+        } else {
+            free(data);
+        }
+#else
+        free(data);
+#endif
+    }
+    data = nullptr;
+    size = 0;
+    mapped = false;
+    entryCount = 0;
+}
+
+bool AssetPack::isOpen() const {
+    return data != nullptr;
+}
+
+const AssetPackEntry *AssetPack::findEntry(const char *name) const {
+    const AssetPackEntry *entries = reinterpret_cast<const AssetPackEntry *>(data + sizeof(AssetPackHeader));
+    for (uint32_t i = 0; i < entryCount; i++) {
+        if (strncmp(entries[i].name, name, ASSET_PACK_NAME_LENGTH) == 0) {
+            return &entries[i];
+        }
+    }
+    return nullptr;
+}
+
+SDL_Texture *AssetPack::loadTexture(SDL_Renderer *renderer, const char *name) const {
+    if (!data) {
+        return nullptr;
+    }
+    const AssetPackEntry *entry = findEntry(name);
+    if (!entry) {
+        return nullptr;
+    }
+
+    uint32_t width = SDL_SwapLE32(entry->width);
+    uint32_t height = SDL_SwapLE32(entry->height);
+    uint32_t offset = SDL_SwapLE32(entry->offset);
+    uint32_t entrySize = SDL_SwapLE32(entry->size);
+    auto encoding = static_cast<AssetEncoding>(SDL_SwapLE32(entry->encoding));
+    size_t pixelCount = static_cast<size_t>(width) * height;
+    if (width == 0 || height == 0 || offset > size || entrySize > size - offset) {
+        return nullptr;
+    }
+
+    const uint8_t *pixels = data + offset;
+    std::vector<uint8_t> decoded;
+    if (encoding == AssetEncoding::RLE) {
+        decoded.resize(pixelCount * 4);
+        decodeRLE(pixels, entrySize, decoded.data(), pixelCount);
+        pixels = decoded.data();
+    } else if (encoding != AssetEncoding::Raw || entrySize < pixelCount * 4) {
+        return nullptr;
+    }
+
+    SDL_Texture *texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, width, height);
+    if (!texture) {
+        return nullptr;
+    }
+    if (SDL_UpdateTexture(texture, nullptr, pixels, width * 4) != 0) {
+        SDL_DestroyTexture(texture);
+        return nullptr;
+    }
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    return texture;
+}
@@ -0,0 +1,95 @@
+#include <BlockPipeline.h>
+#include <cstdio>
+
+bool BlockPipeline::allocate() {
+    for (auto &block : blocks) {
+        block.data.reset(static_cast<uint8_t *>(aligned_alloc(PIPELINE_BLOCK_ALIGNMENT, PIPELINE_BLOCK_SIZE)));
+        if (!block.data) {
+            return false;
+        }
+    }
+    return true;
+}
+
+PipelineBlock *BlockPipeline::acquireEmpty() {
+    std::unique_lock<std::mutex> lock(mutex);
+    PipelineBlock *block = &blocks[readIndex];
+    changed.wait(lock, [&] { return !block->filled || stopped; });
+    return stopped ? nullptr : block;
+}
+
+void BlockPipeline::publish(PipelineBlock *block) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        block->filled = true;
+        readIndex ^= 1;
+    }
+    changed.notify_all();
+}
+
+PipelineBlock *BlockPipeline::acquireFilled() {
+    std::unique_lock<std::mutex> lock(mutex);
+    PipelineBlock *block = &blocks[writeIndex];
+    changed.wait(lock, [&] { return block->filled || finished || stopped; });
+    return block->filled && !stopped ? block : nullptr;
+}
+
+void BlockPipeline::release(PipelineBlock *block) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        block->filled = false;
+        writeIndex ^= 1;
+    }
+    changed.notify_all();
+}
+
+void BlockPipeline::finish() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = true;
+    }
+    changed.notify_all();
+}
+
+void BlockPipeline::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopped = true;
+    }
+    changed.notify_all();
+}
+
+void readFilesIntoPipeline(const std::vector<std::string> &paths, BlockPipeline &pipeline, const std::atomic<bool> &cancelled) {
+    for (uint32_t i = 0; i < paths.size() && !cancelled.load(std::memory_order_relaxed); i++) {
+        FILE *file = fopen(paths[i].c_str(), "rb");
+        if (file) {
+            // Blocks are as large as a transfer should be, a stdio buffer would only add a copy
+            setvbuf(file, nullptr, _IONBF, 0);
+        }
+        bool first = true;
+        bool last = false;
+        while (!last) {
+            PipelineBlock *block = pipeline.acquireEmpty();
+            if (block == nullptr) {
+                if (file) {
+                    fclose(file);
+                }
+                return;
+            }
+            block->file = i;
+            block->size = file ? fread(block->data.get(), 1, PIPELINE_BLOCK_SIZE, file) : 0;
+            block->failed = file == nullptr || ferror(file);
+            // A file ending on a block boundary ends with one empty block.
+            // Cancelling is left to the writer, which drops what it has open.
+            last = block->failed || block->size < PIPELINE_BLOCK_SIZE;
+            block->first = first;
+            block->last = last;
+            first = false;
+            pipeline.publish(block);
+        }
+        if (file) {
+            fclose(file);
+        }
+    }
+    pipeline.finish();
+}
@@ -0,0 +1,88 @@
+#include <CaptureTime.h>
+#include <cstdio>
+
+static bool isTimeSeparator(char c) {
+    return c == '-' || c == '_' || c == ':' || c == ' ' || c == '.';
+}
+
+static bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static bool readDigits(std::string_view text, size_t &pos, int count, uint32_t &value) {
+    if (pos + count > text.size()) {
+        return false;
+    }
+    value = 0;
+    for (int i = 0; i < count; i++) {
+        if (!isDigit(text[pos + i])) {
+            return false;
+        }
+        value = value * 10 + (text[pos + i] - '0');
+    }
+    pos += count;
+    return true;
+}
+
+uint64_t parseCaptureTime(std::string_view text) {
+    static const int widths[6] = {4, 2, 2, 2, 2, 2};
+    for (size_t start = 0; start + 19 <= text.size(); start++) {
+        if (!isDigit(text[start]) || (start > 0 && isDigit(text[start - 1]))) {
+            continue;
+        }
+        uint32_t fields[6];
+        size_t pos = start;
+        bool matched = true;
+        for (int i = 0; i < 6 && matched; i++) {
+            if (i > 0) {
+                matched = pos < text.size() && isTimeSeparator(text[pos]);
+                pos++;
+            }
+            matched = matched && readDigits(text, pos, widths[i], fields[i]);
+        }
+        if (!matched || fields[0] < 1970 || fields[1] < 1 || fields[1] > 12 || fields[2] < 1 || fields[2] > 31 || fields[3] > 23 || fields[4] > 59 ||
+            fields[5] > 59) {
+            continue;
+        }
+
+        uint32_t milliseconds = 0;
+        size_t millisecondsPos = pos + 1;
+        if (pos >= text.size() || !isTimeSeparator(text[pos]) || !readDigits(text, millisecondsPos, 3, milliseconds)) {
+            milliseconds = 0;
+        }
+        uint64_t packed = fields[0];
+        for (int i = 1; i < 6; i++) {
+            packed = packed * 100 + fields[i];
+        }
+        return packed * 1000 + milliseconds;
+    }
+    return CAPTURE_TIME_UNKNOWN;
+}
+
+void formatCaptureTime(uint64_t captureTime, char *text, size_t size) {
+    if (captureTime == CAPTURE_TIME_UNKNOWN) {
+        if (size > 0) {
+            text[0] = '\0';
+        }
+        return;
+    }
+    uint64_t seconds = captureTime / 1000;
+    snprintf(text, size, "%04u-%02u-%02u %02u:%02u:%02u", static_cast<unsigned>(seconds / 10000000000), static_cast<unsigned>(seconds / 100000000 % 100),
+             static_cast<unsigned>(seconds / 1000000 % 100), static_cast<unsigned>(seconds / 10000 % 100), static_cast<unsigned>(seconds / 100 % 100),
+             static_cast<unsigned>(seconds % 100));
+}
+
+uint64_t getPairCaptureTime(const ScreenshotScanner &scanner, const ScreenshotPair &pair, ImageProbe &probe) {
+    uint64_t captureTime = parseCaptureTime(pair.stem);
+    if (captureTime != CAPTURE_TIME_UNKNOWN) {
+        return captureTime;
+    }
+    ImageInfo info;
+    if (pair.tvFormat == ImageFormat::JPG && probe.probe(scanner.buildPath(pair, ScreenshotKind::TV), info) && info.captureTime != CAPTURE_TIME_UNKNOWN) {
+        return info.captureTime;
+    }
+    if (pair.drcFormat == ImageFormat::JPG && probe.probe(scanner.buildPath(pair, ScreenshotKind::DRC), info)) {
+        return info.captureTime;
+    }
+    return CAPTURE_TIME_UNKNOWN;
+}
@@ -0,0 +1,215 @@
+#include <ContactSheet.h>
+#include <PngWriter.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+// Two strip buffers shared by the workers and the encoder. Cell i belongs to
+// strip i / columns, which lives in buffer strip % 2 and may be drawn once the
+// strip two before it has been encoded.
+class StripSchedule {
+public:
+    StripSchedule(uint32_t cellCount, uint32_t columns) : cellCount(cellCount), columns(columns) {
+        for (uint32_t strip = 0; strip < 2; strip++) {
+            remaining[strip] = getCellsInStrip(strip);
+        }
+    }
+
+    // The next cell to draw, or false when there is none or the sheet was abandoned
+    bool acquireCell(uint32_t &cell) {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&] { return stopped || nextCell >= cellCount || nextCell / columns < stripsEncoded + 2; });
+        if (stopped || nextCell >= cellCount) {
+            return false;
+        }
+        cell = nextCell++;
+        return true;
+    }
+
+    void completeCell(uint32_t cell) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--remaining[cell / columns % 2] == 0) {
+            changed.notify_all();
+        }
+    }
+
+    // Encoder side: waits until every cell of the strip is drawn
+    bool waitForStrip(uint32_t strip, const std::atomic<bool> &cancelled) {
+        std::unique_lock<std::mutex> lock(mutex);
+        // Cancelling has no notification of its own, so poll for it
+        while (remaining[strip % 2] > 0 && !cancelled.load(std::memory_order_relaxed)) {
+            changed.wait_for(lock, std::chrono::milliseconds(50));
+        }
+        return remaining[strip % 2] == 0;
+    }
+
+    // Encoder side: the strip's buffer is free for the strip two further on
+    void releaseStrip(uint32_t strip) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            remaining[strip % 2] = getCellsInStrip(strip + 2);
+            stripsEncoded = strip + 1;
+        }
+        changed.notify_all();
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopped = true;
+        }
+        changed.notify_all();
+    }
+
+private:
+    uint32_t getCellsInStrip(uint32_t strip) const {
+        uint32_t first = strip * columns;
+        return first < cellCount ? std::min(columns, cellCount - first) : 0;
+    }
+
+    uint32_t cellCount;
+    uint32_t columns;
+    uint32_t nextCell = 0;
+    uint32_t stripsEncoded = 0;
+    uint32_t remaining[2];
+    bool stopped = false;
+    std::mutex mutex;
+    std::condition_variable changed;
+};
+
+struct SheetLayout {
+    uint32_t columns;
+    uint32_t width;
+    uint32_t stripHeight; // spacing above a row of cells, then the cells
+    size_t pitch;
+};
+
+} // namespace
+
+void boxDownsample(const uint8_t *source, int sourceWidth, int sourceHeight, size_t sourcePitch, uint8_t *destination, int width, int height, size_t pitch) {
+    std::vector<uint32_t> totals(sourceWidth * 3);
+    std::vector<int> columnStart(width + 1);
+    for (int x = 0; x <= width; x++) {
+        columnStart[x] = static_cast<int64_t>(x) * sourceWidth / width;
+    }
+    for (int y = 0; y < height; y++) {
+        int rowStart = static_cast<int64_t>(y) * sourceHeight / height;
+        int rowEnd = std::max(static_cast<int>(static_cast<int64_t>(y + 1) * sourceHeight / height), rowStart + 1);
+        std::fill(totals.begin(), totals.end(), 0);
+        for (int sourceY = rowStart; sourceY < rowEnd; sourceY++) {
+            const uint8_t *row = source + sourceY * sourcePitch;
+            uint32_t *total = totals.data();
+            for (int i = 0; i < sourceWidth * 3; i++) {
+                total[i] += row[i];
+            }
+        }
+        uint8_t *out = destination + y * pitch;
+        for (int x = 0; x < width; x++) {
+            int start = columnStart[x];
+            int end = std::max(columnStart[x + 1], start + 1);
+            uint32_t area = (end - start) * (rowEnd - rowStart);
+            uint32_t red = 0, green = 0, blue = 0;
+            for (int sourceX = start; sourceX < end; sourceX++) {
+                red += totals[sourceX * 3];
+                green += totals[sourceX * 3 + 1];
+                blue += totals[sourceX * 3 + 2];
+            }
+            out[x * 3] = (red + area / 2) / area;
+            out[x * 3 + 1] = (green + area / 2) / area;
+            out[x * 3 + 2] = (blue + area / 2) / area;
+        }
+    }
+}
+
+// Decodes one image and fits it, centered, into its cell of the strip
+static bool drawCell(const std::string &path, uint8_t *cell, size_t pitch) {
+    SDL_Surface *decoded = IMG_Load(path.c_str());
+    if (decoded && decoded->format->format != SDL_PIXELFORMAT_RGB24) {
+        SDL_Surface *converted = SDL_ConvertSurfaceFormat(decoded, SDL_PIXELFORMAT_RGB24, 0);
+        SDL_FreeSurface(decoded);
+        decoded = converted;
+    }
+    if (!decoded) {
+        return false;
+    }
+    bool drawn = decoded->w > 0 && decoded->h > 0;
+    if (drawn) {
+        int width = CONTACT_SHEET_CELL_WIDTH;
+        int height = static_cast<int64_t>(decoded->h) * CONTACT_SHEET_CELL_WIDTH / decoded->w;
+        if (height > CONTACT_SHEET_CELL_HEIGHT) {
+            height = CONTACT_SHEET_CELL_HEIGHT;
+            width = std::max<int>(static_cast<int64_t>(decoded->w) * CONTACT_SHEET_CELL_HEIGHT / decoded->h, 1);
+        }
+        height = std::max(height, 1);
+        uint8_t *origin = cell + (CONTACT_SHEET_CELL_HEIGHT - height) / 2 * pitch + (CONTACT_SHEET_CELL_WIDTH - width) / 2 * 3;
+        boxDownsample(static_cast<const uint8_t *>(decoded->pixels), decoded->w, decoded->h, decoded->pitch, origin, width, height, pitch);
+    }
+    SDL_FreeSurface(decoded);
+    return drawn;
+}
+
+static void drawCells(const std::vector<std::string> &paths, const SheetLayout &layout, uint8_t *const strips[2], StripSchedule &schedule, ContactSheetProgress &progress) {
+    uint32_t cell;
+    while (!progress.cancelled.load(std::memory_order_relaxed) && schedule.acquireCell(cell)) {
+        uint32_t column = cell % layout.columns;
+        uint8_t *origin = strips[cell / layout.columns % 2] + CONTACT_SHEET_SPACING * layout.pitch +
+                          (CONTACT_SHEET_SPACING + column * (CONTACT_SHEET_CELL_WIDTH + CONTACT_SHEET_SPACING)) * 3;
+        if (!drawCell(paths[cell], origin, layout.pitch)) {
+            progress.cellsFailed.fetch_add(1, std::memory_order_relaxed);
+        }
+        progress.cellsDone.fetch_add(1, std::memory_order_relaxed);
+        schedule.completeCell(cell);
+    }
+}
+
+bool writeContactSheet(const std::vector<std::string> &paths, const std::string &outputPath, ContactSheetProgress &progress) {
+    if (paths.empty()) {
+        return false;
+    }
+    SheetLayout layout;
+    layout.columns = std::min<uint32_t>(paths.size(), CONTACT_SHEET_COLUMNS);
+    layout.width = layout.columns * (CONTACT_SHEET_CELL_WIDTH + CONTACT_SHEET_SPACING) + CONTACT_SHEET_SPACING;
+    layout.stripHeight = CONTACT_SHEET_SPACING + CONTACT_SHEET_CELL_HEIGHT;
+    layout.pitch = layout.width * 3;
+    uint32_t stripCount = (paths.size() + layout.columns - 1) / layout.columns;
+
+    std::vector<uint8_t> stripData(layout.pitch * layout.stripHeight * 2, CONTACT_SHEET_BACKGROUND);
+    uint8_t *const strips[2] = {stripData.data(), stripData.data() + layout.pitch * layout.stripHeight};
+    PngWriter writer;
+    if (!writer.open(outputPath, layout.width, stripCount * layout.stripHeight + CONTACT_SHEET_SPACING)) {
+        return false;
+    }
+
+    StripSchedule schedule(paths.size(), layout.columns);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < CONTACT_SHEET_WORKER_COUNT; i++) {
+        workers.emplace_back(drawCells, std::cref(paths), std::cref(layout), strips, std::ref(schedule), std::ref(progress));
+    }
+    bool written = true;
+    for (uint32_t strip = 0; strip < stripCount; strip++) {
+        // On cancel workers may still be drawing into the strip, so it is left alone
+        uint8_t *data = strips[strip % 2];
+        if (!schedule.waitForStrip(strip, progress.cancelled) || !writer.writeRows(data, layout.stripHeight, layout.pitch)) {
+            written = false;
+            break;
+        }
+        memset(data, CONTACT_SHEET_BACKGROUND, layout.pitch * layout.stripHeight);
+        schedule.releaseStrip(strip);
+    }
+    schedule.stop();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    if (!written) {
+        // The writer removes its part file when it goes out of scope
+        return false;
+    }
+    // Spacing below the last row, from the buffer just cleared
+    return writer.writeRows(strips[0], CONTACT_SHEET_SPACING, layout.pitch) && writer.finish();
+}
@@ -0,0 +1,122 @@
+#include <ContentHash.h>
+#include <algorithm>
+#include <cstring>
+
+#define PRIME64_1 0x9E3779B185EBCA87ULL
+#define PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3 0x165667B19E3779F9ULL
+#define PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define PRIME64_5 0x27D4EB2F165667C5ULL
+
+static uint64_t rotateLeft(uint64_t value, int bits) {
+    return value << bits | value >> (64 - bits);
+}
+
+// XXH64 is defined on little-endian words, the Wii U is big-endian
+static uint64_t readLE64(const uint8_t *data) {
+    uint64_t value;
+    memcpy(&value, data, sizeof(value));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    return value;
+}
+
+static uint32_t readLE32(const uint8_t *data) {
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap32(value);
+#endif
+    return value;
+}
+
+static uint64_t mixRound(uint64_t lane, uint64_t input) {
+    lane += input * PRIME64_2;
+    return rotateLeft(lane, 31) * PRIME64_1;
+}
+
+static uint64_t mergeRound(uint64_t hash, uint64_t lane) {
+    hash ^= mixRound(0, lane);
+    return hash * PRIME64_1 + PRIME64_4;
+}
+
+static void consumeStripes(uint64_t *lanes, const uint8_t *data, size_t stripes) {
+    uint64_t v1 = lanes[0], v2 = lanes[1], v3 = lanes[2], v4 = lanes[3];
+    for (size_t i = 0; i < stripes; i++, data += 32) {
+        v1 = mixRound(v1, readLE64(data));
+        v2 = mixRound(v2, readLE64(data + 8));
+        v3 = mixRound(v3, readLE64(data + 16));
+        v4 = mixRound(v4, readLE64(data + 24));
+    }
+    lanes[0] = v1;
+    lanes[1] = v2;
+    lanes[2] = v3;
+    lanes[3] = v4;
+}
+
+ContentHasher::ContentHasher(uint64_t seed) : seed(seed) {
+    lanes[0] = seed + PRIME64_1 + PRIME64_2;
+    lanes[1] = seed + PRIME64_2;
+    lanes[2] = seed;
+    lanes[3] = seed - PRIME64_1;
+}
+
+void ContentHasher::update(const uint8_t *data, size_t size) {
+    totalSize += size;
+    if (stripeSize > 0) {
+        size_t fill = std::min(size, sizeof(stripe) - stripeSize);
+        memcpy(stripe + stripeSize, data, fill);
+        stripeSize += fill;
+        data += fill;
+        size -= fill;
+        if (stripeSize < sizeof(stripe)) {
+            return;
+        }
+        consumeStripes(lanes, stripe, 1);
+        stripeSize = 0;
+    }
+    size_t stripes = size / 32;
+    consumeStripes(lanes, data, stripes);
+    data += stripes * 32;
+    size -= stripes * 32;
+    memcpy(stripe, data, size);
+    stripeSize = size;
+}
+
+uint64_t ContentHasher::digest() const {
+    uint64_t hash;
+    if (totalSize >= 32) {
+        hash = rotateLeft(lanes[0], 1) + rotateLeft(lanes[1], 7) + rotateLeft(lanes[2], 12) + rotateLeft(lanes[3], 18);
+        for (uint64_t lane : lanes) {
+            hash = mergeRound(hash, lane);
+        }
+    } else {
+        hash = seed + PRIME64_5;
+    }
+    hash += totalSize;
+
+    const uint8_t *data = stripe;
+    size_t size = stripeSize;
+    for (; size >= 8; data += 8, size -= 8) {
+        hash ^= mixRound(0, readLE64(data));
+        hash = rotateLeft(hash, 27) * PRIME64_1 + PRIME64_4;
+    }
+    if (size >= 4) {
+        hash ^= readLE32(data) * PRIME64_1;
+        hash = rotateLeft(hash, 23) * PRIME64_2 + PRIME64_3;
+        data += 4;
+        size -= 4;
+    }
+    for (; size > 0; data++, size--) {
+        hash ^= *data * PRIME64_5;
+        hash = rotateLeft(hash, 11) * PRIME64_1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= PRIME64_3;
+    hash ^= hash >> 32;
+    return hash;
+}
@@ -0,0 +1,43 @@
+#include <Crc32.h>
+
+#define CRC32_POLYNOMIAL 0xEDB88320
+
+namespace {
+
+struct Crc32Tables {
+    uint32_t entries[8][256];
+
+    Crc32Tables() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; bit++) {
+                crc = crc & 1 ? crc >> 1 ^ CRC32_POLYNOMIAL : crc >> 1;
+            }
+            entries[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; i++) {
+            for (int slice = 1; slice < 8; slice++) {
+                entries[slice][i] = entries[slice - 1][i] >> 8 ^ entries[0][entries[slice - 1][i] & 0xFF];
+            }
+        }
+    }
+};
+
+const Crc32Tables tables;
+
+} // namespace
+
+uint32_t updateCrc32(uint32_t crc, const uint8_t *data, size_t size) {
+    crc = ~crc;
+    // Bytes are combined explicitly, so this is the same on either endianness
+    for (; size >= 8; data += 8, size -= 8) {
+        uint32_t low = crc ^ (data[0] | data[1] << 8 | data[2] << 16 | static_cast<uint32_t>(data[3]) << 24);
+        uint32_t high = data[4] | data[5] << 8 | data[6] << 16 | static_cast<uint32_t>(data[7]) << 24;
+        crc = tables.entries[7][low & 0xFF] ^ tables.entries[6][low >> 8 & 0xFF] ^ tables.entries[5][low >> 16 & 0xFF] ^ tables.entries[4][low >> 24] ^
+              tables.entries[3][high & 0xFF] ^ tables.entries[2][high >> 8 & 0xFF] ^ tables.entries[1][high >> 16 & 0xFF] ^ tables.entries[0][high >> 24];
+    }
+    for (; size > 0; data++, size--) {
+        crc = tables.entries[0][(crc ^ *data) & 0xFF] ^ crc >> 8;
+    }
+    return ~crc;
+}
@@ -0,0 +1,204 @@
+#include <DirectoryEnumerator.h>
+#include <dirent.h>
+#include <filesystem>
+#include <sys/stat.h>
+#include <vector>
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define GETDENTS_BUFFER_SIZE (32 * 1024)
+
+class FilesystemEnumerator : public DirectoryEnumerator {
+public:
+    bool enumerate(const std::string &rootPath, DirectoryVisitor &visitor) override {
+        std::error_code ec;
+        if (!std::filesystem::is_directory(rootPath, ec)) {
+            return false;
+        }
+
+        std::vector<std::filesystem::path> pending{rootPath};
+        std::vector<std::filesystem::path> subdirectories;
+        while (!pending.empty()) {
+            std::filesystem::path directory = std::move(pending.back());
+            pending.pop_back();
+            if (!visitor.onDirectory(directory.native())) {
+                continue;
+            }
+
+            subdirectories.clear();
+            for (std::filesystem::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+                if (it->is_regular_file(ec)) {
+                    visitor.onFile(it->path().filename().native());
+                } else if (it->is_directory(ec) && !it->is_symlink(ec)) {
+                    subdirectories.push_back(it->path());
+                }
+            }
+            // Reverse so subdirectories are visited in directory order
+            pending.insert(pending.end(), subdirectories.rbegin(), subdirectories.rend());
+        }
+        return true;
+    }
+};
+
+class PosixEnumerator : public DirectoryEnumerator {
+public:
+    bool enumerate(const std::string &rootPath, DirectoryVisitor &visitor) override {
+        std::vector<std::string> pending;
+        pending.push_back(rootPath);
+        std::string &root = pending.back();
+        while (root.size() > 1 && root.back() == '/' && root[root.size() - 2] != ':') {
+            root.pop_back();
+        }
+
+        bool rootOpened = false;
+        std::vector<std::string> subdirectories;
+        while (!pending.empty()) {
+            std::string directory = std::move(pending.back());
+            pending.pop_back();
+            if (!visitor.onDirectory(directory)) {
+                continue;
+            }
+
+            subdirectories.clear();
+            if (readDirectory(directory, visitor, subdirectories)) {
+                rootOpened = true;
+            }
+            pending.insert(pending.end(), std::make_move_iterator(subdirectories.rbegin()), std::make_move_iterator(subdirectories.rend()));
+        }
+        return rootOpened;
+    }
+
+private:
+    enum class EntryType {
+        File,
+        Directory,
+        Other,
+    };
+
+    static EntryType statEntryType(const std::string &path) {
+        struct stat st {};
+        if (stat(path.c_str(), &st) != 0) {
+            return EntryType::Other;
+        }
+        if (S_ISREG(st.st_mode)) {
+            return EntryType::File;
+        }
+        return S_ISDIR(st.st_mode) ? EntryType::Directory : EntryType::Other;
+    }
+
+    static bool isDotEntry(const char *name) {
+        return name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+    }
+
+    void handleEntry(const std::string &directory, const char *name, EntryType type, bool resolve, DirectoryVisitor &visitor, std::vector<std::string> &subdirectories) {
+        if (isDotEntry(name)) {
+            return;
+        }
+        if (resolve) {
+            // Only reached when the backend could not report the type. Like
+            // std::filesystem, symlinks to directories are not followed.
+            entryPath.assign(directory).append("/").append(name);
+            EntryType resolved = statEntryType(entryPath);
+            if (type == EntryType::Other && resolved == EntryType::Directory) {
+                return;
+            }
+            type = resolved;
+        }
+        if (type == EntryType::File) {
+            visitor.onFile(name);
+        } else if (type == EntryType::Directory) {
+            subdirectories.push_back(directory + "/" + name);
+        }
+    }
+
+#ifdef __linux__
+    struct LinuxDirent64 {
+        ino64_t d_ino;
+        off64_t d_off;
+        unsigned short d_reclen;
+        unsigned char d_type;
+        char d_name[];
+    };
+
+    // getdents64 hands back a whole buffer of entries per syscall
+    bool readDirectory(const std::string &directory, DirectoryVisitor &visitor, std::vector<std::string> &subdirectories) {
+        int fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        if (buffer.empty()) {
+            buffer.resize(GETDENTS_BUFFER_SIZE);
+        }
+        long bytesRead;
+        while ((bytesRead = syscall(SYS_getdents64, fd, buffer.data(), buffer.size())) > 0) {
+            for (long offset = 0; offset < bytesRead;) {
+                auto *entry = reinterpret_cast<LinuxDirent64 *>(buffer.data() + offset);
+                offset += entry->d_reclen;
+                switch (entry->d_type) {
+                    case DT_REG:
+                        handleEntry(directory, entry->d_name, EntryType::File, false, visitor, subdirectories);
+                        break;
+                    case DT_DIR:
+                        handleEntry(directory, entry->d_name, EntryType::Directory, false, visitor, subdirectories);
+                        break;
+                    case DT_LNK:
+                        handleEntry(directory, entry->d_name, EntryType::Other, true, visitor, subdirectories);
+                        break;
+                    case DT_UNKNOWN:
+                        handleEntry(directory, entry->d_name, EntryType::File, true, visitor, subdirectories);
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+        close(fd);
+        return true;
+    }
+
+    std::vector<char> buffer;
+#else
+    // The Wii U devoptab fills d_type from the FSReadDir result it already has,
+    // so readdir never needs a stat per entry there
+    bool readDirectory(const std::string &directory, DirectoryVisitor &visitor, std::vector<std::string> &subdirectories) {
+        DIR *dir = opendir(directory.c_str());
+        if (dir == nullptr) {
+            return false;
+        }
+        while (struct dirent *entry = readdir(dir)) {
+#ifdef DT_UNKNOWN
+            switch (entry->d_type) {
+                case DT_REG:
+                    handleEntry(directory, entry->d_name, EntryType::File, false, visitor, subdirectories);
+                    break;
+                case DT_DIR:
+                    handleEntry(directory, entry->d_name, EntryType::Directory, false, visitor, subdirectories);
+                    break;
+                case DT_UNKNOWN:
+                    handleEntry(directory, entry->d_name, EntryType::File, true, visitor, subdirectories);
+                    break;
+                default:
+                    handleEntry(directory, entry->d_name, EntryType::Other, true, visitor, subdirectories);
+                    break;
+            }
+#else
+            handleEntry(directory, entry->d_name, EntryType::File, true, visitor, subdirectories);
+#endif
+        }
+        closedir(dir);
+        return true;
+    }
+#endif
+
+    std::string entryPath;
+};
+
+std::unique_ptr<DirectoryEnumerator> createDirectoryEnumerator(DirectoryBackend backend) {
+    if (backend == DirectoryBackend::Filesystem) {
+        return std::make_unique<FilesystemEnumerator>();
+    }
+    return std::make_unique<PosixEnumerator>();
+}
@@ -0,0 +1,116 @@
+#include <ContentHash.h>
+#include <DuplicateFinder.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <sys/stat.h>
+#include <thread>
+
+#define FILE_SIZE_UNKNOWN UINT64_MAX
+
+// Runs work(i) for every i below count, handing out indices in order
+static void runOnWorkers(size_t count, const std::function<void(size_t index, uint8_t *buffer)> &work) {
+    std::atomic<size_t> next{0};
+    auto loop = [&]() {
+        std::unique_ptr<uint8_t, decltype(&free)> buffer(static_cast<uint8_t *>(aligned_alloc(DUPLICATE_READ_ALIGNMENT, DUPLICATE_READ_SIZE)), free);
+        if (!buffer) {
+            return;
+        }
+        for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+            work(i, buffer.get());
+        }
+    };
+    std::vector<std::thread> workers;
+    for (int i = 1; i < DUPLICATE_WORKER_COUNT; i++) {
+        workers.emplace_back(loop);
+    }
+    loop();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+static bool hashFile(const std::string &path, uint8_t *buffer, uint64_t &hash) {
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    // The buffer is already as large as a read should be, stdio's would only add a copy
+    setvbuf(file, nullptr, _IONBF, 0);
+    ContentHasher hasher;
+    size_t read;
+    while ((read = fread(buffer, 1, DUPLICATE_READ_SIZE, file)) > 0) {
+        hasher.update(buffer, read);
+    }
+    bool ok = !ferror(file);
+    fclose(file);
+    hash = hasher.digest();
+    return ok;
+}
+
+std::vector<uint32_t> findDuplicateFiles(const std::vector<std::string> &paths, const std::vector<uint8_t> &wanted, DuplicateProgress &progress) {
+    std::vector<uint64_t> sizes(paths.size(), FILE_SIZE_UNKNOWN);
+    runOnWorkers(paths.size(), [&](size_t i, uint8_t *) {
+        struct stat st {};
+        if (stat(paths[i].c_str(), &st) == 0) {
+            sizes[i] = st.st_size;
+        }
+        progress.filesSized.fetch_add(1, std::memory_order_relaxed);
+    });
+
+    // Sorted by size, a run of equal sizes is a set of candidates
+    std::vector<uint32_t> order(paths.size());
+    for (uint32_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sizes[a] != sizes[b] ? sizes[a] < sizes[b] : a < b; });
+    std::vector<uint32_t> candidates;
+    for (size_t first = 0; first < order.size();) {
+        size_t last = first + 1;
+        bool anyWanted = wanted[order[first]];
+        while (last < order.size() && sizes[order[last]] == sizes[order[first]]) {
+            anyWanted = anyWanted || wanted[order[last]];
+            last++;
+        }
+        if (last - first > 1 && anyWanted && sizes[order[first]] != FILE_SIZE_UNKNOWN) {
+            candidates.insert(candidates.end(), order.begin() + first, order.begin() + last);
+        }
+        first = last;
+    }
+
+    progress.filesToHash.store(candidates.size(), std::memory_order_relaxed);
+    std::vector<uint64_t> hashes(paths.size(), 0);
+    std::vector<uint8_t> hashed(paths.size(), 0);
+    runOnWorkers(candidates.size(), [&](size_t i, uint8_t *buffer) {
+        uint32_t file = candidates[i];
+        hashed[file] = hashFile(paths[file], buffer, hashes[file]);
+        progress.filesHashed.fetch_add(1, std::memory_order_relaxed);
+    });
+
+    // Equal size and equal hash make a group
+    candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [&](uint32_t file) { return !hashed[file]; }), candidates.end());
+    std::sort(candidates.begin(), candidates.end(), [&](uint32_t a, uint32_t b) {
+        if (sizes[a] != sizes[b]) {
+            return sizes[a] < sizes[b];
+        }
+        return hashes[a] != hashes[b] ? hashes[a] < hashes[b] : a < b;
+    });
+    std::vector<uint32_t> groups(paths.size(), DUPLICATE_GROUP_NONE);
+    uint32_t groupCount = 0;
+    for (size_t first = 0; first < candidates.size();) {
+        size_t last = first + 1;
+        while (last < candidates.size() && sizes[candidates[last]] == sizes[candidates[first]] && hashes[candidates[last]] == hashes[candidates[first]]) {
+            last++;
+        }
+        if (last - first > 1) {
+            for (size_t i = first; i < last; i++) {
+                groups[candidates[i]] = groupCount;
+            }
+            groupCount++;
+        }
+        first = last;
+    }
+    return groups;
+}
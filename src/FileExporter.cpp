@@ -0,0 +1,81 @@
+#include <BlockPipeline.h>
+#include <FileExporter.h>
+#include <cstdio>
+#include <sys/stat.h>
+#include <thread>
+
+bool exportFiles(const std::vector<ExportFile> &files, ExportProgress &progress) {
+    uint64_t total = 0;
+    for (const auto &file : files) {
+        struct stat st {};
+        if (stat(file.source.c_str(), &st) == 0) {
+            total += st.st_size;
+        }
+    }
+    progress.bytesTotal.store(total, std::memory_order_relaxed);
+
+    BlockPipeline pipeline;
+    if (!pipeline.allocate()) {
+        progress.filesFailed.store(files.size(), std::memory_order_relaxed);
+        return false;
+    }
+    std::vector<std::string> sources;
+    sources.reserve(files.size());
+    for (const auto &file : files) {
+        sources.push_back(file.source);
+    }
+    std::thread reader(readFilesIntoPipeline, std::cref(sources), std::ref(pipeline), std::cref(progress.cancelled));
+
+    FILE *output = nullptr;
+    std::string partPath;
+    bool writeFailed = false;
+    while (PipelineBlock *block = pipeline.acquireFilled()) {
+        if (progress.cancelled.load(std::memory_order_relaxed)) {
+            pipeline.stop();
+            break;
+        }
+        const ExportFile &file = files[block->file];
+        if (output == nullptr && !writeFailed && !block->failed) {
+            partPath = file.destination + EXPORT_PART_SUFFIX;
+            output = fopen(partPath.c_str(), "wb");
+            if (output) {
+                setvbuf(output, nullptr, _IONBF, 0);
+            }
+            writeFailed = output == nullptr;
+        }
+        if (output && !block->failed && block->size > 0) {
+            writeFailed = fwrite(block->data.get(), 1, block->size, output) != block->size;
+        }
+        progress.bytesCopied.fetch_add(block->size, std::memory_order_relaxed);
+
+        if (block->last) {
+            bool copied = output && !writeFailed && !block->failed;
+            if (output) {
+                copied = fclose(output) == 0 && copied;
+                output = nullptr;
+            }
+            if (copied) {
+                // FAT cannot rename over an existing file
+                remove(file.destination.c_str());
+                copied = rename(partPath.c_str(), file.destination.c_str()) == 0;
+            }
+            if (!copied) {
+                remove(partPath.c_str());
+            }
+            (copied ? progress.filesCopied : progress.filesFailed).fetch_add(1, std::memory_order_relaxed);
+            writeFailed = false;
+        } else if (writeFailed && output) {
+            // Keep draining this file's blocks, the reader is ahead already
+            fclose(output);
+            output = nullptr;
+            remove(partPath.c_str());
+        }
+        pipeline.release(block);
+    }
+    if (output) {
+        fclose(output);
+        remove(partPath.c_str());
+    }
+    reader.join();
+    return progress.filesCopied.load(std::memory_order_relaxed) == files.size();
+}
@@ -0,0 +1,224 @@
+#include <CaptureTime.h>
+#include <FolderIndex.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+
+static int64_t getModifiedTime(const std::string &path) {
+    struct stat st {};
+    if (stat(path.c_str(), &st) != 0) {
+        return -1;
+    }
+    return st.st_mtime;
+}
+
+FolderIndex::FolderIndex(const std::string &rootPath) : rootPath(rootPath) {
+    while (this->rootPath.size() > 1 && this->rootPath.back() == '/' && this->rootPath[this->rootPath.size() - 2] != ':') {
+        this->rootPath.pop_back();
+    }
+    indexPath = this->rootPath;
+    if (indexPath.back() != '/') {
+        indexPath.push_back('/');
+    }
+    indexPath.append(FOLDER_INDEX_FILE_NAME);
+}
+
+void FolderIndex::refresh(ScanProgress *progress) {
+    std::vector<FolderEntry> saved;
+    load(saved);
+    std::sort(saved.begin(), saved.end(), [](const FolderEntry &a, const FolderEntry &b) {
+        return a.name < b.name;
+    });
+
+    listedFolders.clear();
+    rootHasScreenshots = false;
+    rootListed = false;
+    createDirectoryEnumerator(DirectoryBackend::Posix)->enumerate(rootPath, *this);
+    std::sort(listedFolders.begin(), listedFolders.end());
+    if (rootHasScreenshots) {
+        listedFolders.insert(listedFolders.begin(), std::string());
+    }
+
+    folders.clear();
+    emptyFolders.clear();
+    dirty = saved.size() != listedFolders.size();
+    for (auto &name : listedFolders) {
+        FolderEntry entry{std::move(name), 0, CAPTURE_TIME_UNKNOWN, 0, {}, ImageFormat::Unknown, ImageFormat::Unknown};
+        entry.modifiedTime = getModifiedTime(entry.name.empty() ? rootPath : rootPath + "/" + entry.name);
+        auto it = std::lower_bound(saved.begin(), saved.end(), entry.name, [](const FolderEntry &a, const std::string &name) {
+            return a.name < name;
+        });
+        if (it != saved.end() && it->name == entry.name && it->modifiedTime == entry.modifiedTime && entry.modifiedTime != -1) {
+            entry = std::move(*it);
+        } else {
+            scanFolder(entry, progress);
+            dirty = true;
+        }
+        // Empty folders stay in the index so they are not rescanned every start
+        if (entry.pairCount > 0) {
+            folders.push_back(std::move(entry));
+        } else {
+            emptyFolders.push_back(std::move(entry));
+        }
+    }
+    listedFolders.clear();
+    save();
+}
+
+std::string FolderIndex::getPath(size_t folder) const {
+    if (folders[folder].name.empty()) {
+        return rootPath;
+    }
+    std::string path;
+    path.reserve(rootPath.size() + folders[folder].name.size() + 1);
+    path.append(rootPath);
+    path.push_back('/');
+    path.append(folders[folder].name);
+    return path;
+}
+
+std::string_view FolderIndex::getDisplayName(size_t folder) const {
+    if (folders[folder].name.empty()) {
+        return "Screenshots";
+    }
+    return folders[folder].name;
+}
+
+void FolderIndex::update(size_t folder, uint32_t pairCount, uint64_t newestCapture, std::string_view coverStem, ImageFormat coverTVFormat, ImageFormat coverDRCFormat) {
+    FolderEntry &entry = folders[folder];
+    if (entry.pairCount == pairCount && entry.newestCapture == newestCapture && entry.coverStem == coverStem && entry.coverTVFormat == coverTVFormat &&
+        entry.coverDRCFormat == coverDRCFormat) {
+        return;
+    }
+    entry.pairCount = pairCount;
+    entry.newestCapture = newestCapture;
+    entry.coverStem = coverStem;
+    entry.coverTVFormat = coverTVFormat;
+    entry.coverDRCFormat = coverDRCFormat;
+    // Deletes change the folder's time as well, so the saved one would no
+    // longer match
+    entry.modifiedTime = getModifiedTime(getPath(folder));
+    dirty = true;
+}
+
+bool FolderIndex::save() {
+    if (!dirty) {
+        return true;
+    }
+    // Written next to the index and renamed over it, so an interrupted save
+    // leaves the previous index intact
+    std::string tempPath = indexPath + ".tmp";
+    FILE *file = fopen(tempPath.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    FolderIndexHeader header{FOLDER_INDEX_MAGIC, FOLDER_INDEX_VERSION, static_cast<uint32_t>(folders.size() + emptyFolders.size()), 0};
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+    for (const auto *entries : {&folders, &emptyFolders}) {
+        for (const auto &entry : *entries) {
+            FolderIndexRecord record{};
+            record.modifiedTime = entry.modifiedTime;
+            record.newestCapture = entry.newestCapture;
+            record.pairCount = entry.pairCount;
+            record.nameLength = entry.name.size();
+            record.stemLength = entry.coverStem.size();
+            record.coverTVFormat = entry.coverTVFormat;
+            record.coverDRCFormat = entry.coverDRCFormat;
+            written = written && fwrite(&record, sizeof(record), 1, file) == 1;
+            written = written && fwrite(entry.name.data(), 1, entry.name.size(), file) == entry.name.size();
+            written = written && fwrite(entry.coverStem.data(), 1, entry.coverStem.size(), file) == entry.coverStem.size();
+        }
+    }
+    written = fclose(file) == 0 && written;
+    if (!written || rename(tempPath.c_str(), indexPath.c_str()) != 0) {
+        remove(tempPath.c_str());
+        return false;
+    }
+    dirty = false;
+    return true;
+}
+
+bool FolderIndex::onDirectory(std::string_view path) {
+    if (!rootListed) {
+        rootListed = true;
+        return true;
+    }
+    // Only the top level is listed, folders are scanned when they change
+    size_t nameStart = path.rfind('/');
+    std::string_view name = nameStart == std::string_view::npos ? path : path.substr(nameStart + 1);
+    if (!name.empty() && name[0] != '.') {
+        listedFolders.emplace_back(name);
+    }
+    return false;
+}
+
+void FolderIndex::onFile(std::string_view name) {
+    if (!rootHasScreenshots && classifyScreenshotName(name).kind != ScreenshotKind::None) {
+        rootHasScreenshots = true;
+    }
+}
+
+void FolderIndex::load(std::vector<FolderEntry> &saved) const {
+    FILE *file = fopen(indexPath.c_str(), "rb");
+    if (file == nullptr) {
+        return;
+    }
+    std::vector<uint8_t> data;
+    struct stat st {};
+    if (fstat(fileno(file), &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(FolderIndexHeader))) {
+        data.resize(st.st_size);
+        if (fread(data.data(), data.size(), 1, file) != 1) {
+            data.clear();
+        }
+    }
+    fclose(file);
+    if (data.empty()) {
+        return;
+    }
+
+    FolderIndexHeader header;
+    memcpy(&header, data.data(), sizeof(header));
+    if (header.magic != FOLDER_INDEX_MAGIC || header.version != FOLDER_INDEX_VERSION) {
+        return;
+    }
+    size_t offset = sizeof(header);
+    saved.reserve(std::min<size_t>(header.entryCount, data.size() / sizeof(FolderIndexRecord)));
+    for (uint32_t i = 0; i < header.entryCount; i++) {
+        FolderIndexRecord record;
+        if (data.size() - offset < sizeof(record)) {
+            break;
+        }
+        memcpy(&record, data.data() + offset, sizeof(record));
+        offset += sizeof(record);
+        if (data.size() - offset < static_cast<size_t>(record.nameLength) + record.stemLength) {
+            break;
+        }
+        const char *text = reinterpret_cast<const char *>(data.data() + offset);
+        saved.push_back({std::string(text, record.nameLength), record.modifiedTime, record.newestCapture, record.pairCount, std::string(text + record.nameLength, record.stemLength),
+                         record.coverTVFormat, record.coverDRCFormat});
+        offset += record.nameLength + record.stemLength;
+    }
+}
+
+void FolderIndex::scanFolder(FolderEntry &entry, ScanProgress *progress) const {
+    ScreenshotScanner scanner(progress);
+    scanner.scan(entry.name.empty() ? rootPath : rootPath + "/" + entry.name, DirectoryBackend::Posix, false);
+    const auto &pairs = scanner.getPairs();
+    entry.pairCount = pairs.size();
+    // Pairs come sorted by stem, so on equal times the last stem wins, as in the grid
+    const ScreenshotPair *cover = nullptr;
+    ImageProbe probe;
+    for (const auto &pair : pairs) {
+        uint64_t captureTime = getPairCaptureTime(scanner, pair, probe);
+        if (cover == nullptr || captureTime >= entry.newestCapture) {
+            cover = &pair;
+            entry.newestCapture = captureTime;
+        }
+    }
+    if (cover != nullptr) {
+        entry.coverStem = cover->stem;
+        entry.coverTVFormat = cover->tvFormat;
+        entry.coverDRCFormat = cover->drcFormat;
+    }
+}
@@ -0,0 +1,121 @@
+#include <CaptureTime.h>
+#include <HashCache.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <sys/stat.h>
+#include <unordered_map>
+
+void loadHashCache(const std::string &folderPath, ImageLibrary &library, const std::vector<SlotHandle> &handles) {
+    FILE *file = fopen((folderPath + "/" HASH_CACHE_FILE_NAME).c_str(), "rb");
+    if (file == nullptr) {
+        return;
+    }
+    std::vector<uint8_t> data;
+    struct stat st {};
+    if (fstat(fileno(file), &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(HashCacheHeader))) {
+        data.resize(st.st_size);
+        if (fread(data.data(), data.size(), 1, file) != 1) {
+            data.clear();
+        }
+    }
+    fclose(file);
+    if (data.empty()) {
+        return;
+    }
+
+    HashCacheHeader header;
+    memcpy(&header, data.data(), sizeof(header));
+    if (header.magic != HASH_CACHE_MAGIC || header.version != HASH_CACHE_VERSION) {
+        return;
+    }
+    // Stems point into `data`, which outlives the map
+    std::unordered_map<std::string_view, HashCacheRecord> records;
+    records.reserve(std::min<size_t>(header.entryCount, data.size() / sizeof(HashCacheRecord)));
+    size_t offset = sizeof(header);
+    for (uint32_t i = 0; i < header.entryCount; i++) {
+        HashCacheRecord record;
+        if (data.size() - offset < sizeof(record)) {
+            break;
+        }
+        memcpy(&record, data.data() + offset, sizeof(record));
+        offset += sizeof(record);
+        if (data.size() - offset < record.stemLength) {
+            break;
+        }
+        records.emplace(std::string_view(reinterpret_cast<const char *>(data.data() + offset), record.stemLength), record);
+        offset += record.stemLength;
+    }
+
+    for (SlotHandle handle : handles) {
+        auto it = records.find(library.getStem(handle));
+        if (it == records.end()) {
+            continue;
+        }
+        const HashCacheRecord &record = it->second;
+        if ((record.flags & HASH_CACHE_FLAG_HASH) && record.format == library.getFormat(handle, library.getHashedKind(handle))) {
+            library.setPerceptualHash(handle, {record.bits, record.sharpness});
+        }
+        if ((record.flags & HASH_CACHE_FLAG_CAPTURE_TIME) && !(library.getFlags(handle) & IMAGE_FLAG_TIMED)) {
+            library.setCaptureTime(handle, record.captureTime);
+        }
+    }
+}
+
+// Only times that took a header read are worth keeping, the rest come from
+// the name
+static uint8_t getRecordFlags(const ImageLibrary &library, SlotHandle handle) {
+    uint8_t flags = 0;
+    if (library.getFlags(handle) & IMAGE_FLAG_HASHED) {
+        flags |= HASH_CACHE_FLAG_HASH;
+    }
+    if ((library.getFlags(handle) & IMAGE_FLAG_TIMED) && parseCaptureTime(library.getStem(handle)) == CAPTURE_TIME_UNKNOWN) {
+        flags |= HASH_CACHE_FLAG_CAPTURE_TIME;
+    }
+    return flags;
+}
+
+bool saveHashCache(const std::string &folderPath, const ImageLibrary &library, const std::vector<SlotHandle> &handles) {
+    std::string cachePath = folderPath + "/" HASH_CACHE_FILE_NAME;
+    // Written next to the cache and renamed over it, like the folder index
+    std::string tempPath = cachePath + ".tmp";
+    FILE *file = fopen(tempPath.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    HashCacheHeader header{HASH_CACHE_MAGIC, HASH_CACHE_VERSION, 0, 0};
+    std::vector<uint8_t> recordFlags(handles.size());
+    for (size_t i = 0; i < handles.size(); i++) {
+        recordFlags[i] = getRecordFlags(library, handles[i]);
+        if (recordFlags[i] != 0) {
+            header.entryCount++;
+        }
+    }
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+    for (size_t i = 0; i < handles.size(); i++) {
+        if (recordFlags[i] == 0) {
+            continue;
+        }
+        SlotHandle handle = handles[i];
+        std::string_view stem = library.getStem(handle);
+        HashCacheRecord record{};
+        if (recordFlags[i] & HASH_CACHE_FLAG_HASH) {
+            const PerceptualHash &hash = library.getPerceptualHash(handle);
+            record.bits = hash.bits;
+            record.sharpness = hash.sharpness;
+            record.format = library.getFormat(handle, library.getHashedKind(handle));
+        }
+        record.captureTime = library.getCaptureTime(handle);
+        record.stemLength = stem.size();
+        record.flags = recordFlags[i];
+        written = written && fwrite(&record, sizeof(record), 1, file) == 1;
+        written = written && fwrite(stem.data(), 1, stem.size(), file) == stem.size();
+    }
+    written = fclose(file) == 0 && written;
+    if (!written || rename(tempPath.c_str(), cachePath.c_str()) != 0) {
+        remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,117 @@
+#include <CaptureTime.h>
+#include <ImageLibrary.h>
+
+uint32_t ImageLibrary::addFolder(std::string_view path) {
+    return paths.addDirectory(path);
+}
+
+SlotHandle ImageLibrary::add(uint32_t folder, std::string_view stem, ImageFormat tvFormat, ImageFormat drcFormat) {
+    PathStem pathStem = paths.addStem(stem);
+    uint32_t pathTV = PATH_ID_NONE;
+    uint32_t pathDRC = PATH_ID_NONE;
+    uint8_t imageFlags = 0;
+    if (tvFormat != ImageFormat::Unknown) {
+        pathTV = paths.addFile(folder, pathStem, ScreenshotKind::TV, tvFormat);
+        imageFlags |= IMAGE_FLAG_HAS_TV;
+    }
+    if (drcFormat != ImageFormat::Unknown) {
+        pathDRC = paths.addFile(folder, pathStem, ScreenshotKind::DRC, drcFormat);
+        imageFlags |= IMAGE_FLAG_HAS_DRC;
+    }
+
+    SlotHandle handle = records.insert({folder, pathTV, pathDRC});
+    if (records.capacity() > flags.size()) {
+        thumbnailTV.resize(records.capacity());
+        thumbnailDRC.resize(records.capacity());
+        flags.resize(records.capacity());
+        captureTimes.resize(records.capacity());
+        infoTV.resize(records.capacity());
+        infoDRC.resize(records.capacity());
+        hashes.resize(records.capacity());
+    }
+    thumbnailTV[handle.index] = THUMBNAIL_SLOT_NONE;
+    thumbnailDRC[handle.index] = THUMBNAIL_SLOT_NONE;
+    flags[handle.index] = imageFlags;
+    captureTimes[handle.index] = CAPTURE_TIME_UNKNOWN;
+    return handle;
+}
+
+bool ImageLibrary::remove(SlotHandle handle) {
+    if (!records.contains(handle)) {
+        return false;
+    }
+    const ColdRecord &record = records[handle];
+    if (record.pathTV != PATH_ID_NONE) {
+        paths.remove(record.pathTV);
+    }
+    if (record.pathDRC != PATH_ID_NONE) {
+        paths.remove(record.pathDRC);
+    }
+    records.erase(handle);
+    thumbnailTV[handle.index] = THUMBNAIL_SLOT_NONE;
+    thumbnailDRC[handle.index] = THUMBNAIL_SLOT_NONE;
+    flags[handle.index] = 0;
+    captureTimes[handle.index] = CAPTURE_TIME_UNKNOWN;
+    return true;
+}
+
+void ImageLibrary::reserve(size_t count) {
+    records.reserve(count);
+    thumbnailTV.reserve(count);
+    thumbnailDRC.reserve(count);
+    flags.reserve(count);
+    captureTimes.reserve(count);
+    infoTV.reserve(count);
+    infoDRC.reserve(count);
+    hashes.reserve(count);
+    // Two files per pair and room for a typical "YYYY-MM-DD_hh-mm-ss-mmm" stem
+    paths.reserve(count * 2, count * 24);
+}
+
+void ImageLibrary::clear() {
+    records.clear();
+    thumbnailTV.assign(thumbnailTV.size(), THUMBNAIL_SLOT_NONE);
+    thumbnailDRC.assign(thumbnailDRC.size(), THUMBNAIL_SLOT_NONE);
+    flags.assign(flags.size(), 0);
+    captureTimes.assign(captureTimes.size(), CAPTURE_TIME_UNKNOWN);
+    paths.clear();
+}
+
+std::string_view ImageLibrary::getStem(SlotHandle handle) const {
+    const ColdRecord &record = records[handle];
+    return paths.getStem(record.pathTV != PATH_ID_NONE ? record.pathTV : record.pathDRC);
+}
+
+ImageFormat ImageLibrary::getFormat(SlotHandle handle, ScreenshotKind kind) const {
+    uint32_t file = kind == ScreenshotKind::TV ? records[handle].pathTV : records[handle].pathDRC;
+    return file == PATH_ID_NONE ? ImageFormat::Unknown : paths.getFormat(file);
+}
+
+void ImageLibrary::setFormat(SlotHandle handle, ScreenshotKind kind, ImageFormat format) {
+    uint32_t file = kind == ScreenshotKind::TV ? records[handle].pathTV : records[handle].pathDRC;
+    if (file != PATH_ID_NONE) {
+        paths.setFormat(file, format);
+        flags[handle.index] &= ~IMAGE_FLAG_PROBED;
+    }
+}
+
+void ImageLibrary::buildPath(SlotHandle handle, ScreenshotKind kind, std::string &path) const {
+    uint32_t file = kind == ScreenshotKind::TV ? records[handle].pathTV : records[handle].pathDRC;
+    if (file == PATH_ID_NONE) {
+        path.clear();
+        return;
+    }
+    paths.buildPath(file, path);
+}
+
+std::string ImageLibrary::getPathTV(SlotHandle handle) const {
+    std::string path;
+    buildPath(handle, ScreenshotKind::TV, path);
+    return path;
+}
+
+std::string ImageLibrary::getPathDRC(SlotHandle handle) const {
+    std::string path;
+    buildPath(handle, ScreenshotKind::DRC, path);
+    return path;
+}
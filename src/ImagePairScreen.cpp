@@ -1,10 +1,83 @@
+#include <CaptureTime.h>
 #include <ImagePairScreen.h>
+#include <SDL2/SDL_image.h>
+#ifdef __WIIU__
+#include <coreinit/thread.h>
+#endif
+
+// EXIF orientations 5 to 8 are stored turned by a quarter
+static bool isQuarterTurned(uint8_t orientation) {
+    return orientation >= 5 && orientation <= 8;
+}
+
+SDL_Rect fitImageRect(const ImageInfo *info, const SDL_Rect &box) {
+    if (info == nullptr || info->width == 0 || info->height == 0) {
+        return box;
+    }
+    bool turned = isQuarterTurned(info->orientation);
+    uint64_t width = turned ? info->height : info->width;
+    uint64_t height = turned ? info->width : info->height;
+    SDL_Rect fitted = box;
+    if (width * box.h > height * box.w) {
+        fitted.h = static_cast<int>(height * box.w / width);
+        fitted.y += (box.h - fitted.h) / 2;
+    } else {
+        fitted.w = static_cast<int>(width * box.h / height);
+        fitted.x += (box.w - fitted.w) / 2;
+    }
+    return fitted;
+}
+
+void renderFittedImage(SDL_Renderer *renderer, SDL_Texture *texture, const ImageInfo *info, const SDL_Rect &box) {
+    SDL_Rect fitted = fitImageRect(info, box);
+    uint8_t orientation = info ? info->orientation : 1;
+    if (orientation <= 1 || orientation > 8) {
+        SDL_RenderCopy(renderer, texture, nullptr, &fitted);
+        return;
+    }
+    // SDL flips first and then rotates clockwise around the centre
+    static const double angles[9] = {0, 0, 0, 180, 180, 270, 90, 90, 270};
+    static const bool mirrored[9] = {false, false, true, false, true, true, false, true, false};
+    SDL_Rect dest = fitted;
+    if (isQuarterTurned(orientation)) {
+        dest = {fitted.x + (fitted.w - fitted.h) / 2, fitted.y + (fitted.h - fitted.w) / 2, fitted.h, fitted.w};
+    }
+    SDL_RenderCopyEx(renderer, texture, nullptr, &dest, angles[orientation], nullptr, mirrored[orientation] ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE);
+}
+
+ImagePairScreen::~ImagePairScreen() {
+    {
+        std::lock_guard<std::mutex> lock(decodeMutex);
+        stopping = true;
+    }
+    decodeCondition.notify_all();
+    decodeThread.join();
+    releaseTextures();
+}
 
 void ImagePairScreen::handleEvent(const SDL_Event &event) {
-    arrowButton.handleEvent(event);
+    if (animationStep == 0) {
+        zoomView.handleEvent(event);
+    }
+    // Zoomed in, the D-pad and touches belong to the view
+    if (!zoomView.isZoomed()) {
+        arrowButton.handleEvent(event);
+    }
 }
 
-void ImagePairScreen::render() {
+void ImagePairScreen::render(float seconds) {
+    uploadDecoded();
+    if (animationStep == 0) {
+        zoomView.update(seconds);
+        if (zoomView.isZoomed()) {
+            zoomView.render();
+            if (infoVisible) {
+                renderInfo(imageState == SingleImageState::TV ? infoTV : infoDRC);
+            }
+            return;
+        }
+    }
+
     int slideStepAmount = SCREEN_WIDTH / animationSteps;
 
     if (animationStep > 0 && animationStep <= animationSteps) {
@@ -31,8 +104,11 @@ void ImagePairScreen::render() {
         }
     }
 
-    SDL_RenderCopy(renderer, imagesPair->textureTV, nullptr, &fullscreenTVRect);
-    SDL_RenderCopy(renderer, imagesPair->textureDRC, nullptr, &fullscreenDRCRect);
+    renderFittedImage(renderer, getTexture(ScreenshotKind::TV), &infoTV, fullscreenTVRect);
+    renderFittedImage(renderer, getTexture(ScreenshotKind::DRC), &infoDRC, fullscreenDRCRect);
+    if (infoVisible && animationStep == 0) {
+        renderInfo(imageState == SingleImageState::TV ? infoTV : infoDRC);
+    }
 
     if (arrowButton.isAnimationInProgress()) {
         arrowButton.updateButton(0, 0, false);
@@ -56,8 +132,27 @@ void ImagePairScreen::render() {
     }
 }
 
-void ImagePairScreen::setImagePair(ImagesPair *imagesPair) {
+void ImagePairScreen::setImagePair(SlotHandle imagesPair) {
+    releaseTextures();
     this->imagesPair = imagesPair;
+    infoTV = {};
+    infoDRC = {};
+    if (library->contains(imagesPair)) {
+        bool probed = library->getFlags(imagesPair) & IMAGE_FLAG_PROBED;
+        if (probed) {
+            infoTV = *library->getInfo(imagesPair, ScreenshotKind::TV);
+            infoDRC = *library->getInfo(imagesPair, ScreenshotKind::DRC);
+        }
+        {
+            std::lock_guard<std::mutex> lock(decodeMutex);
+            library->buildPath(imagesPair, ScreenshotKind::TV, decodePaths[0]);
+            library->buildPath(imagesPair, ScreenshotKind::DRC, decodePaths[1]);
+            // Opened before the background probe got to it, the images are
+            // laid out without metadata until the decode thread has read it
+            probePending = !probed;
+        }
+        decodeCondition.notify_one();
+    }
     // Reset all variables
     this->imageState = SingleImageState::TV;
     this->arrowRect = {0, (SCREEN_HEIGHT / 2) - 145, 290, 290};
@@ -67,4 +162,161 @@ void ImagePairScreen::setImagePair(ImagesPair *imagesPair) {
     this->arrowVisible = true;
     this->arrowButton.setRect(arrowRect);
     this->arrowButton.setControllerButton((SDL_GameControllerButton) 0xe);
+    resetZoom();
+}
+
+void ImagePairScreen::renderInfo(const ImageInfo &info) {
+    if (info.width == 0) {
+        return;
+    }
+    char captureTime[32];
+    formatCaptureTime(library->contains(imagesPair) && library->getCaptureTime(imagesPair) != CAPTURE_TIME_UNKNOWN ? library->getCaptureTime(imagesPair) : info.captureTime,
+                      captureTime, sizeof(captureTime));
+    SDL_Rect band = {0, SCREEN_HEIGHT - INFO_OVERLAY_HEIGHT, SCREEN_WIDTH, INFO_OVERLAY_HEIGHT};
+    SDL_Color prevColor = {0, 0, 0, 0};
+    SDL_GetRenderDrawColor(renderer, &prevColor.r, &prevColor.g, &prevColor.b, &prevColor.a);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 160);
+    SDL_RenderFillRect(renderer, &band);
+    SDL_SetRenderDrawColor(renderer, prevColor.r, prevColor.g, prevColor.b, prevColor.a);
+    FC_DrawAlign(font, renderer, SCREEN_WIDTH / 2, band.y + (INFO_OVERLAY_HEIGHT - FC_GetLineHeight(font)) / 2, FC_ALIGN_CENTER, "%ux%u    %s    %u KB    %s",
+                 static_cast<unsigned>(info.width), static_cast<unsigned>(info.height), getImageFormatExtension(info.format) + 1,
+                 static_cast<unsigned>((info.fileSize + 1023) / 1024), captureTime);
+}
+
+void ImagePairScreen::decodeLoop() {
+#ifdef __WIIU__
+    OSSetThreadPriority(OSGetCurrentThread(), IMAGE_PAIR_THREAD_PRIORITY);
+#endif
+    std::unique_lock<std::mutex> lock(decodeMutex);
+    while (true) {
+        decodeCondition.wait(lock, [&] { return stopping || !decodePaths[0].empty() || !decodePaths[1].empty(); });
+        if (stopping) {
+            return;
+        }
+        uint32_t generation = decodeGeneration;
+        if (probePending) {
+            probePending = false;
+            std::string paths[2] = {decodePaths[0], decodePaths[1]};
+            lock.unlock();
+
+            ImageInfo info[2] = {};
+            for (int half = 0; half < 2; half++) {
+                if (!paths[half].empty()) {
+                    probe.probe(paths[half], info[half]);
+                }
+            }
+
+            lock.lock();
+            if (generation == decodeGeneration) {
+                probedInfo[0] = info[0];
+                probedInfo[1] = info[1];
+                probeReady = true;
+            }
+            continue;
+        }
+        int half = decodePaths[0].empty() ? 1 : 0;
+        std::string path = std::move(decodePaths[half]);
+        decodePaths[half].clear();
+        lock.unlock();
+
+        SDL_Surface *surface = IMG_Load(path.c_str());
+        if (surface && ZoomView::needsLevels(surface->w, surface->h) && surface->format->format != SDL_PIXELFORMAT_RGBA32) {
+            // The zoom view builds its levels from these pixels
+            SDL_Surface *converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+            SDL_FreeSurface(surface);
+            surface = converted;
+        }
+
+        lock.lock();
+        // A failed decode leaves the thumbnail up
+        if (generation == decodeGeneration && surface) {
+            decodedSurfaces[half] = surface;
+        } else {
+            SDL_FreeSurface(surface);
+        }
+    }
+}
+
+void ImagePairScreen::uploadDecoded() {
+    SDL_Surface *surface = nullptr;
+    bool tv = true;
+    bool probed = false;
+    {
+        std::lock_guard<std::mutex> lock(decodeMutex);
+        if (probeReady) {
+            probeReady = false;
+            probed = true;
+            infoTV = probedInfo[0];
+            infoDRC = probedInfo[1];
+        }
+        for (int half = 0; half < 2 && surface == nullptr; half++) {
+            surface = decodedSurfaces[half];
+            decodedSurfaces[half] = nullptr;
+            tv = half == 0;
+        }
+    }
+    if (probed) {
+        // Rotated images are not zoomable, the view may have to let go
+        resetZoom();
+    }
+    if (surface == nullptr) {
+        return;
+    }
+    SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
+    if (texture && ZoomView::needsLevels(surface->w, surface->h)) {
+        (tv ? fullPixelsTV : fullPixelsDRC) = std::shared_ptr<SDL_Surface>(surface, SDL_FreeSurface);
+    } else {
+        SDL_FreeSurface(surface);
+    }
+    (tv ? fullTextureTV : fullTextureDRC) = texture;
+    // The zoom view was cleared while the half in view had no texture
+    if (texture && tv == (imageState == SingleImageState::TV)) {
+        resetZoom();
+    }
+}
+
+SDL_Texture *ImagePairScreen::getTexture(ScreenshotKind kind) const {
+    SDL_Texture *texture = kind == ScreenshotKind::TV ? fullTextureTV : fullTextureDRC;
+    if (texture == nullptr && thumbnailFunction && library->contains(imagesPair)) {
+        texture = thumbnailFunction(imagesPair, kind);
+    }
+    return texture;
+}
+
+void ImagePairScreen::resetZoom() {
+    bool tv = imageState == SingleImageState::TV;
+    SDL_Texture *texture = tv ? fullTextureTV : fullTextureDRC;
+    // Tiles are drawn as stored, so EXIF rotated images are not zoomable
+    if (texture == nullptr || (tv ? infoTV : infoDRC).orientation > 1) {
+        zoomView.clear();
+        return;
+    }
+    zoomView.setImage(texture, tv ? fullPixelsTV : fullPixelsDRC);
+}
+
+void ImagePairScreen::releaseTextures() {
+    {
+        std::lock_guard<std::mutex> lock(decodeMutex);
+        decodeGeneration++;
+        probePending = false;
+        probeReady = false;
+        for (int half = 0; half < 2; half++) {
+            decodePaths[half].clear();
+            SDL_FreeSurface(decodedSurfaces[half]);
+            decodedSurfaces[half] = nullptr;
+        }
+    }
+    // The view still points at the textures
+    zoomView.clear();
+    fullPixelsTV.reset();
+    fullPixelsDRC.reset();
+    if (fullTextureTV) {
+        SDL_DestroyTexture(fullTextureTV);
+        fullTextureTV = nullptr;
+    }
+    if (fullTextureDRC) {
+        SDL_DestroyTexture(fullTextureDRC);
+        fullTextureDRC = nullptr;
+    }
 }
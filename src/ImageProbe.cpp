@@ -0,0 +1,259 @@
+#include <CaptureTime.h>
+#include <ImageProbe.h>
+#include <algorithm>
+#include <cstring>
+#include <sys/stat.h>
+
+#define EXIF_TAG_ORIENTATION        0x0112
+#define EXIF_TAG_DATE_TIME          0x0132
+#define EXIF_TAG_EXIF_IFD           0x8769
+#define EXIF_TAG_DATE_TIME_ORIGINAL 0x9003
+#define EXIF_TYPE_ASCII             2
+#define EXIF_TYPE_SHORT             3
+#define EXIF_TYPE_LONG              4
+
+static uint16_t readBE16(const uint8_t *data) {
+    return data[0] << 8 | data[1];
+}
+
+static uint32_t readBE32(const uint8_t *data) {
+    return static_cast<uint32_t>(data[0]) << 24 | data[1] << 16 | data[2] << 8 | data[3];
+}
+
+static uint32_t readLE16(const uint8_t *data) {
+    return data[0] | data[1] << 8;
+}
+
+static uint32_t readLE32(const uint8_t *data) {
+    return data[0] | data[1] << 8 | data[2] << 16 | static_cast<uint32_t>(data[3]) << 24;
+}
+
+static bool readAt(FILE *file, long offset, void *data, size_t size) {
+    return fseek(file, offset, SEEK_SET) == 0 && fread(data, size, 1, file) == 1;
+}
+
+// TIFF structure of the EXIF block, in either byte order
+class TiffReader {
+public:
+    TiffReader(const uint8_t *data, size_t size) : data(data), size(size) {
+        littleEndian = size >= 8 && data[0] == 'I' && data[1] == 'I';
+        valid = size >= 8 && (littleEndian || (data[0] == 'M' && data[1] == 'M'));
+    }
+
+    bool isValid() const {
+        return valid;
+    }
+
+    uint16_t read16(size_t offset) const {
+        if (offset > size || size - offset < 2) {
+            return 0;
+        }
+        return littleEndian ? readLE16(data + offset) : readBE16(data + offset);
+    }
+
+    uint32_t read32(size_t offset) const {
+        if (offset > size || size - offset < 4) {
+            return 0;
+        }
+        return littleEndian ? readLE32(data + offset) : readBE32(data + offset);
+    }
+
+    // Looks up one tag of an IFD and returns the offset of its 12-byte entry
+    size_t findEntry(uint32_t ifd, uint16_t tag) const {
+        if (ifd > size || size - ifd < 2) {
+            return 0;
+        }
+        // Entries that would run past the end are never looked at, so the
+        // offsets below cannot wrap
+        size_t count = std::min<size_t>(read16(ifd), (size - ifd - 2) / 12);
+        for (size_t i = 0; i < count; i++) {
+            size_t entry = ifd + 2 + i * 12;
+            if (read16(entry) == tag) {
+                return entry;
+            }
+        }
+        return 0;
+    }
+
+    uint64_t readTime(size_t entry) const {
+        if (entry == 0 || read16(entry + 2) != EXIF_TYPE_ASCII) {
+            return CAPTURE_TIME_UNKNOWN;
+        }
+        uint32_t count = read32(entry + 4);
+        size_t offset = count <= 4 ? entry + 8 : read32(entry + 8);
+        if (offset >= size || count > size - offset) {
+            return CAPTURE_TIME_UNKNOWN;
+        }
+        return parseCaptureTime({reinterpret_cast<const char *>(data + offset), count});
+    }
+
+private:
+    const uint8_t *data;
+    size_t size;
+    bool littleEndian;
+    bool valid;
+};
+
+ImageProbe::ImageProbe() : streamBuffer(std::make_unique<char[]>(IMAGE_PROBE_BUFFER_SIZE)) {
+}
+
+bool ImageProbe::probe(const std::string &path, ImageInfo &info) {
+    info = {CAPTURE_TIME_UNKNOWN, 0, 0, 0, ImageFormat::Unknown, 1};
+    if (path.empty()) {
+        return false;
+    }
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    setvbuf(file, streamBuffer.get(), _IOFBF, IMAGE_PROBE_BUFFER_SIZE);
+    struct stat st {};
+    if (fstat(fileno(file), &st) == 0) {
+        info.fileSize = st.st_size;
+    }
+
+    // The signature decides, not the extension
+    uint8_t magic[2];
+    bool probed = false;
+    if (fread(magic, sizeof(magic), 1, file) == 1) {
+        if (magic[0] == 0xFF && magic[1] == 0xD8) {
+            probed = probeJPEG(file, info);
+        } else if (magic[0] == 0x89 && magic[1] == 'P') {
+            probed = probePNG(file, info);
+        } else if (magic[0] == 'B' && magic[1] == 'M') {
+            probed = probeBMP(file, info);
+        }
+    }
+    fclose(file);
+    return probed;
+}
+
+bool ImageProbe::probeJPEG(FILE *file, ImageInfo &info) {
+    info.format = ImageFormat::JPG;
+    long offset = 2;
+    for (int segment = 0; segment < IMAGE_PROBE_MAX_SEGMENTS; segment++) {
+        uint8_t header[4];
+        if (!readAt(file, offset, header, sizeof(header)) || header[0] != 0xFF) {
+            return false;
+        }
+        uint8_t marker = header[1];
+        if (marker == 0xFF) {
+            // Fill byte before the actual marker
+            offset++;
+            continue;
+        }
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+            offset += 2;
+            continue;
+        }
+        // The frame header always comes before the scan data
+        if (marker == 0xDA || marker == 0xD9) {
+            return false;
+        }
+        uint16_t length = readBE16(header + 2);
+        if (length < 2) {
+            return false;
+        }
+
+        if (marker == 0xE1 && info.captureTime == CAPTURE_TIME_UNKNOWN) {
+            exifBuffer.resize(length - 2);
+            if (fread(exifBuffer.data(), exifBuffer.size(), 1, file) == 1) {
+                parseExif(exifBuffer.data(), exifBuffer.size(), info);
+            }
+        } else if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            // Start of frame: precision, height, width
+            uint8_t frame[5];
+            if (fread(frame, sizeof(frame), 1, file) != 1) {
+                return false;
+            }
+            info.height = readBE16(frame + 1);
+            info.width = readBE16(frame + 3);
+            return info.width > 0 && info.height > 0;
+        }
+        offset += 2 + length;
+    }
+    return false;
+}
+
+bool ImageProbe::parseExif(const uint8_t *data, size_t size, ImageInfo &info) {
+    if (size < 6 || memcmp(data, "Exif\0\0", 6) != 0) {
+        return false;
+    }
+    TiffReader tiff(data + 6, size - 6);
+    if (!tiff.isValid()) {
+        return false;
+    }
+    uint32_t ifd0 = tiff.read32(4);
+    size_t orientationEntry = tiff.findEntry(ifd0, EXIF_TAG_ORIENTATION);
+    if (orientationEntry != 0 && tiff.read16(orientationEntry + 2) == EXIF_TYPE_SHORT) {
+        uint16_t orientation = tiff.read16(orientationEntry + 8);
+        info.orientation = orientation >= 1 && orientation <= 8 ? orientation : 1;
+    }
+    size_t exifIfdEntry = tiff.findEntry(ifd0, EXIF_TAG_EXIF_IFD);
+    if (exifIfdEntry != 0 && tiff.read16(exifIfdEntry + 2) == EXIF_TYPE_LONG) {
+        info.captureTime = tiff.readTime(tiff.findEntry(tiff.read32(exifIfdEntry + 8), EXIF_TAG_DATE_TIME_ORIGINAL));
+    }
+    if (info.captureTime == CAPTURE_TIME_UNKNOWN) {
+        info.captureTime = tiff.readTime(tiff.findEntry(ifd0, EXIF_TAG_DATE_TIME));
+    }
+    return true;
+}
+
+bool ImageProbe::probePNG(FILE *file, ImageInfo &info) {
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    uint8_t header[8];
+    if (!readAt(file, 0, header, sizeof(header)) || memcmp(header, signature, sizeof(signature)) != 0) {
+        return false;
+    }
+    info.format = ImageFormat::PNG;
+    // IHDR comes first; tIME, if there is one, somewhere before the image data
+    long offset = 8;
+    for (int chunk = 0; chunk < IMAGE_PROBE_MAX_SEGMENTS; chunk++) {
+        uint8_t chunkHeader[8];
+        if (!readAt(file, offset, chunkHeader, sizeof(chunkHeader))) {
+            break;
+        }
+        uint32_t length = readBE32(chunkHeader);
+        const uint8_t *type = chunkHeader + 4;
+        if (memcmp(type, "IHDR", 4) == 0) {
+            uint8_t size[8];
+            if (fread(size, sizeof(size), 1, file) != 1) {
+                return false;
+            }
+            info.width = readBE32(size);
+            info.height = readBE32(size + 4);
+        } else if (memcmp(type, "tIME", 4) == 0) {
+            uint8_t time[7];
+            if (fread(time, sizeof(time), 1, file) == 1) {
+                uint64_t packed = readBE16(time);
+                for (int i = 2; i < 7; i++) {
+                    packed = packed * 100 + time[i];
+                }
+                info.captureTime = packed * 1000;
+            }
+        } else if (memcmp(type, "IDAT", 4) == 0 || memcmp(type, "IEND", 4) == 0) {
+            break;
+        }
+        offset += 12 + static_cast<long>(length);
+    }
+    return info.width > 0 && info.height > 0;
+}
+
+bool ImageProbe::probeBMP(FILE *file, ImageInfo &info) {
+    uint8_t header[26];
+    if (!readAt(file, 0, header, sizeof(header))) {
+        return false;
+    }
+    info.format = ImageFormat::BMP;
+    // The old OS/2 header has 16-bit sizes, everything newer 32-bit ones
+    if (readLE32(header + 14) == 12) {
+        info.width = readLE16(header + 18);
+        info.height = readLE16(header + 20);
+    } else {
+        // A negative height marks a top-down bitmap
+        int32_t height = static_cast<int32_t>(readLE32(header + 22));
+        info.width = static_cast<int32_t>(readLE32(header + 18)) > 0 ? readLE32(header + 18) : 0;
+        info.height = height < 0 ? -static_cast<int64_t>(height) : height;
+    }
+    return info.width > 0 && info.height > 0;
+}
@@ -0,0 +1,90 @@
+#include <MetadataProber.h>
+#ifdef __WIIU__
+#include <coreinit/thread.h>
+#endif
+
+MetadataProber::MetadataProber() {
+    worker = std::thread(&MetadataProber::workerLoop, this);
+}
+
+MetadataProber::~MetadataProber() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        pending.clear();
+    }
+    condition.notify_all();
+    worker.join();
+}
+
+void MetadataProber::submit(std::vector<ProbeJob> &&jobs) {
+    if (jobs.empty()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto &job : jobs) {
+            pending.push_back(std::move(job));
+        }
+    }
+    condition.notify_one();
+}
+
+void MetadataProber::collect(std::vector<ProbeResult> &results) {
+    std::lock_guard<std::mutex> lock(mutex);
+    results.insert(results.end(), completed.begin(), completed.end());
+    completed.clear();
+}
+
+void MetadataProber::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.clear();
+    completed.clear();
+    epoch++;
+}
+
+void MetadataProber::waitUntilIdle() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return !probing; });
+}
+
+void MetadataProber::workerLoop() {
+#ifdef __WIIU__
+    OSSetThreadPriority(OSGetCurrentThread(), METADATA_PROBE_THREAD_PRIORITY);
+#endif
+    // One probe for the whole run, its buffers are reused for every file
+    ImageProbe probe;
+    std::vector<ProbeJob> batch;
+    std::vector<ProbeResult> results;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        condition.wait(lock, [this] { return stopping || !pending.empty(); });
+        if (stopping) {
+            return;
+        }
+
+        batch.clear();
+        while (!pending.empty() && batch.size() < METADATA_PROBE_BATCH_SIZE) {
+            batch.push_back(std::move(pending.front()));
+            pending.pop_front();
+        }
+        uint32_t batchEpoch = epoch;
+        probing = true;
+        lock.unlock();
+
+        results.clear();
+        for (const auto &job : batch) {
+            ProbeResult result{job.handle, {}, {}};
+            probe.probe(job.pathTV, result.tv);
+            probe.probe(job.pathDRC, result.drc);
+            results.push_back(result);
+        }
+
+        lock.lock();
+        if (batchEpoch == epoch) {
+            completed.insert(completed.end(), results.begin(), results.end());
+        }
+        probing = false;
+        idle.notify_all();
+    }
+}
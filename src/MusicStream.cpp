@@ -0,0 +1,156 @@
+#include <MusicStream.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+struct MusicStreamState {
+    FILE *file;
+    Sint64 fileSize;
+    Sint64 position;     // logical read position seen by the decoder
+    Sint64 filePosition; // where the next refill will read from
+    size_t head;         // ring index of the byte at `position`
+    size_t level;        // bytes buffered ahead of `position`
+    size_t behind;       // already consumed bytes still valid before `head`
+    uint8_t ring[MUSIC_STREAM_RING_SIZE];
+};
+
+static MusicStreamState *getState(SDL_RWops *context) {
+    return static_cast<MusicStreamState *>(context->hidden.unknown.data1);
+}
+
+static void refill(MusicStreamState *state) {
+    while (state->level < MUSIC_STREAM_RING_SIZE / 2 && state->filePosition < state->fileSize) {
+        size_t tail = (state->head + state->level) % MUSIC_STREAM_RING_SIZE;
+        size_t writable = std::min<size_t>(MUSIC_STREAM_RING_SIZE - state->level, MUSIC_STREAM_RING_SIZE - tail);
+        writable = std::min<size_t>(writable, MUSIC_STREAM_READ_CHUNK);
+        size_t bytesRead = fread(state->ring + tail, 1, writable, state->file);
+        if (bytesRead == 0) {
+            break;
+        }
+        state->level += bytesRead;
+        state->filePosition += bytesRead;
+        state->behind = std::min(state->behind, MUSIC_STREAM_RING_SIZE - state->level);
+    }
+}
+
+static Sint64 streamSize(SDL_RWops *context) {
+    return getState(context)->fileSize;
+}
+
+static Sint64 streamSeek(SDL_RWops *context, Sint64 offset, int whence) {
+    MusicStreamState *state = getState(context);
+    Sint64 target;
+    switch (whence) {
+        case RW_SEEK_SET:
+            target = offset;
+            break;
+        case RW_SEEK_CUR:
+            target = state->position + offset;
+            break;
+        case RW_SEEK_END:
+            target = state->fileSize + offset;
+            break;
+        default:
+            return SDL_SetError("Unknown seek mode");
+    }
+    target = std::clamp<Sint64>(target, 0, state->fileSize);
+
+    Sint64 delta = target - state->position;
+    if (delta >= 0 && delta <= static_cast<Sint64>(state->level)) {
+        state->head = (state->head + delta) % MUSIC_STREAM_RING_SIZE;
+        state->level -= delta;
+        state->behind = std::min<size_t>(state->behind + delta, MUSIC_STREAM_RING_SIZE - state->level);
+    } else if (delta < 0 && -delta <= static_cast<Sint64>(state->behind)) {
+        state->head = (state->head + MUSIC_STREAM_RING_SIZE + delta) % MUSIC_STREAM_RING_SIZE;
+        state->level -= delta;
+        state->behind += delta;
+    } else {
+        if (fseek(state->file, target, SEEK_SET) != 0) {
+            return SDL_SetError("Failed to seek music stream");
+        }
+        state->filePosition = target;
+        state->head = 0;
+        state->level = 0;
+        state->behind = 0;
+    }
+    state->position = target;
+    return target;
+}
+
+static size_t streamRead(SDL_RWops *context, void *ptr, size_t size, size_t maxnum) {
+    MusicStreamState *state = getState(context);
+    if (size == 0) {
+        return 0;
+    }
+
+    uint8_t *dst = static_cast<uint8_t *>(ptr);
+    size_t remaining = size * maxnum;
+    size_t copied = 0;
+    while (remaining > 0) {
+        refill(state);
+        if (state->level == 0) {
+            break;
+        }
+        size_t contiguous = std::min(state->level, MUSIC_STREAM_RING_SIZE - state->head);
+        size_t amount = std::min(contiguous, remaining);
+        memcpy(dst + copied, state->ring + state->head, amount);
+        state->head = (state->head + amount) % MUSIC_STREAM_RING_SIZE;
+        state->level -= amount;
+        state->behind = std::min(state->behind + amount, MUSIC_STREAM_RING_SIZE - state->level);
+        state->position += amount;
+        copied += amount;
+        remaining -= amount;
+    }
+    return copied / size;
+}
+
+static size_t streamWrite(SDL_RWops *, const void *, size_t, size_t) {
+    SDL_SetError("Music stream is read-only");
+    return 0;
+}
+
+static int streamClose(SDL_RWops *context) {
+    if (context) {
+        MusicStreamState *state = getState(context);
+        fclose(state->file);
+        delete state;
+        SDL_FreeRW(context);
+    }
+    return 0;
+}
+
+SDL_RWops *openMusicStream(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (file == nullptr) {
+        SDL_SetError("Couldn't open %s", path);
+        return nullptr;
+    }
+    // The ring does the buffering, stdio's own buffer would only add a copy
+    setvbuf(file, nullptr, _IONBF, 0);
+
+    MusicStreamState *state = new (std::nothrow) MusicStreamState{};
+    SDL_RWops *context = SDL_AllocRW();
+    if (state == nullptr || context == nullptr) {
+        delete state;
+        if (context) {
+            SDL_FreeRW(context);
+        }
+        fclose(file);
+        return nullptr;
+    }
+
+    fseek(file, 0, SEEK_END);
+    state->file = file;
+    state->fileSize = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    context->size = streamSize;
+    context->seek = streamSeek;
+    context->read = streamRead;
+    context->write = streamWrite;
+    context->close = streamClose;
+    context->type = SDL_RWOPS_UNKNOWN;
+    context->hidden.unknown.data1 = state;
+    return context;
+}
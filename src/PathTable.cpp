@@ -0,0 +1,105 @@
+#include <PathTable.h>
+#include <cstring>
+#include <unordered_map>
+
+#define PATH_FILE_REMOVED UINT32_MAX
+
+uint32_t PathTable::append(std::string_view text) {
+    uint32_t offset = static_cast<uint32_t>(pool.size());
+    pool.append(text);
+    return offset;
+}
+
+uint32_t PathTable::addDirectory(std::string_view path) {
+    directories.push_back({append(path), static_cast<uint32_t>(path.size())});
+    return static_cast<uint32_t>(directories.size() - 1);
+}
+
+PathStem PathTable::addStem(std::string_view stem) {
+    return {append(stem), static_cast<uint32_t>(stem.size())};
+}
+
+uint32_t PathTable::addFile(uint32_t directory, PathStem stem, ScreenshotKind kind, ImageFormat format) {
+    File file = {directory, stem.offset, static_cast<uint16_t>(stem.length), kind, format};
+    if (!freeFiles.empty()) {
+        uint32_t id = freeFiles.back();
+        freeFiles.pop_back();
+        files[id] = file;
+        return id;
+    }
+    files.push_back(file);
+    return static_cast<uint32_t>(files.size() - 1);
+}
+
+void PathTable::remove(uint32_t file) {
+    files[file].directory = PATH_FILE_REMOVED;
+    freeFiles.push_back(file);
+    if (++removedFiles > files.size() / 2) {
+        compact();
+    }
+}
+
+// Rebuilds the pool from the directories and the stems still in use, shared
+// stems keep being shared
+void PathTable::compact() {
+    std::string compacted;
+    compacted.reserve(pool.size());
+    for (Directory &directory : directories) {
+        uint32_t offset = static_cast<uint32_t>(compacted.size());
+        compacted.append(pool, directory.offset, directory.length);
+        directory.offset = offset;
+    }
+    std::unordered_map<uint32_t, uint32_t> stems;
+    for (File &file : files) {
+        if (file.directory == PATH_FILE_REMOVED) {
+            continue;
+        }
+        auto [it, inserted] = stems.try_emplace(file.stemOffset, static_cast<uint32_t>(compacted.size()));
+        if (inserted) {
+            compacted.append(pool, file.stemOffset, file.stemLength);
+        }
+        file.stemOffset = it->second;
+    }
+    compacted.shrink_to_fit();
+    pool = std::move(compacted);
+    removedFiles = 0;
+}
+
+std::string_view PathTable::getDirectory(uint32_t directory) const {
+    return std::string_view(pool).substr(directories[directory].offset, directories[directory].length);
+}
+
+std::string_view PathTable::getStem(uint32_t file) const {
+    return std::string_view(pool).substr(files[file].stemOffset, files[file].stemLength);
+}
+
+void PathTable::buildPath(uint32_t file, std::string &path) const {
+    const File &entry = files[file];
+    std::string_view directory = getDirectory(entry.directory);
+    const char *suffix = getScreenshotKindSuffix(entry.kind);
+    const char *extension = getImageFormatExtension(entry.format);
+    path.clear();
+    path.reserve(directory.size() + entry.stemLength + strlen(suffix) + strlen(extension) + 1);
+    path.append(directory);
+    path.push_back('/');
+    path.append(pool, entry.stemOffset, entry.stemLength);
+    path.append(suffix);
+    path.append(extension);
+}
+
+void PathTable::reserve(size_t fileCount, size_t poolBytes) {
+    files.reserve(fileCount);
+    pool.reserve(poolBytes);
+}
+
+void PathTable::clear() {
+    pool.clear();
+    directories.clear();
+    files.clear();
+    freeFiles.clear();
+    removedFiles = 0;
+}
+
+size_t PathTable::getMemoryUsage() const {
+    return pool.capacity() + directories.capacity() * sizeof(Directory) + files.capacity() * sizeof(File) + freeFiles.capacity() * sizeof(uint32_t);
+}
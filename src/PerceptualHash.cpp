@@ -0,0 +1,182 @@
+#include <PerceptualHash.h>
+#include <ThumbnailScheduler.h>
+#include <algorithm>
+#include <cstdlib>
+#include <numeric>
+#include <thread>
+
+#define HASH_COLUMNS 9
+#define HASH_ROWS    8
+
+// Written as plain loops over contiguous bytes with no branches in the inner
+// loops, so compilers turn them into vector code where the target has it
+static void convertToLuma(const uint8_t *pixels, int width, uint8_t *luma) {
+    for (int x = 0; x < width; x++) {
+        const uint8_t *pixel = pixels + x * 4;
+        luma[x] = (pixel[0] * 77 + pixel[1] * 150 + pixel[2] * 29) >> 8;
+    }
+}
+
+static uint32_t sumRange(const uint8_t *luma, int first, int last) {
+    uint32_t sum = 0;
+    for (int x = first; x < last; x++) {
+        sum += luma[x];
+    }
+    return sum;
+}
+
+static uint32_t sumGradients(const uint8_t *luma, const uint8_t *previous, int width) {
+    uint32_t sum = 0;
+    for (int x = 0; x + 1 < width; x++) {
+        sum += std::abs(luma[x + 1] - luma[x]) + std::abs(luma[x] - previous[x]);
+    }
+    return sum;
+}
+
+PerceptualHash computePerceptualHash(const uint8_t *pixels, int width, int height, int pitch) {
+    PerceptualHash hash{0, 0};
+    if (width < HASH_COLUMNS || height < HASH_ROWS) {
+        return hash;
+    }
+    int columnEdges[HASH_COLUMNS + 1];
+    for (int i = 0; i <= HASH_COLUMNS; i++) {
+        columnEdges[i] = i * width / HASH_COLUMNS;
+    }
+
+    std::vector<uint8_t> rows(width * 2);
+    uint8_t *luma = rows.data();
+    uint8_t *previous = rows.data() + width;
+    uint32_t cells[HASH_ROWS][HASH_COLUMNS] = {};
+    uint32_t cellHeights[HASH_ROWS] = {};
+    uint64_t sharpness = 0;
+    for (int y = 0; y < height; y++) {
+        convertToLuma(pixels + y * pitch, width, luma);
+        int row = y * HASH_ROWS / height;
+        cellHeights[row]++;
+        for (int column = 0; column < HASH_COLUMNS; column++) {
+            cells[row][column] += sumRange(luma, columnEdges[column], columnEdges[column + 1]);
+        }
+        if (y > 0) {
+            sharpness += sumGradients(luma, previous, width);
+        }
+        std::swap(luma, previous);
+    }
+
+    for (int row = 0; row < HASH_ROWS; row++) {
+        for (int column = 0; column + 1 < HASH_COLUMNS; column++) {
+            // Compare averages without dividing: cross-multiply by the widths
+            uint64_t left = static_cast<uint64_t>(cells[row][column]) * (columnEdges[column + 2] - columnEdges[column + 1]);
+            uint64_t right = static_cast<uint64_t>(cells[row][column + 1]) * (columnEdges[column + 1] - columnEdges[column]);
+            hash.bits = hash.bits << 1 | (left < right);
+        }
+    }
+    // Per pixel, so the score does not depend on the thumbnail size
+    hash.sharpness = static_cast<uint32_t>(sharpness * 16 / (static_cast<uint64_t>(width) * height));
+    return hash;
+}
+
+static uint32_t findRoot(std::vector<uint32_t> &parents, uint32_t index) {
+    while (parents[index] != index) {
+        parents[index] = parents[parents[index]];
+        index = parents[index];
+    }
+    return index;
+}
+
+static void joinSets(std::vector<uint32_t> &parents, uint32_t a, uint32_t b) {
+    a = findRoot(parents, a);
+    b = findRoot(parents, b);
+    if (a != b) {
+        parents[std::max(a, b)] = std::min(a, b);
+    }
+}
+
+std::vector<std::vector<uint32_t>> findSimilarClusters(const std::vector<uint64_t> &hashes, int maxDistance) {
+    std::vector<uint32_t> parents(hashes.size());
+    std::iota(parents.begin(), parents.end(), 0);
+
+    // Identical hashes are joined in one pass, so a run of blank screenshots
+    // never turns into a quadratic number of comparisons below
+    std::vector<uint32_t> order(hashes.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return hashes[a] != hashes[b] ? hashes[a] < hashes[b] : a < b; });
+    std::vector<uint32_t> unique;
+    for (size_t i = 0; i < order.size(); i++) {
+        if (i > 0 && hashes[order[i]] == hashes[order[i - 1]]) {
+            joinSets(parents, order[i - 1], order[i]);
+        } else {
+            unique.push_back(order[i]);
+        }
+    }
+
+    // Hashes within maxDistance < PERCEPTUAL_HASH_BANDS bits agree on at
+    // least one whole band, so each band is bucketed and only hashes in the
+    // same bucket are compared
+    std::vector<uint32_t> bucket(unique.size());
+    for (int band = 0; band < PERCEPTUAL_HASH_BANDS && maxDistance > 0; band++) {
+        int shift = band * 8;
+        auto bandOf = [&](uint32_t index) { return static_cast<uint8_t>(hashes[index] >> shift); };
+        bucket = unique;
+        std::sort(bucket.begin(), bucket.end(), [&](uint32_t a, uint32_t b) { return bandOf(a) != bandOf(b) ? bandOf(a) < bandOf(b) : a < b; });
+        for (size_t first = 0; first < bucket.size();) {
+            size_t last = first + 1;
+            while (last < bucket.size() && bandOf(bucket[last]) == bandOf(bucket[first])) {
+                last++;
+            }
+            for (size_t i = first; i < last; i++) {
+                for (size_t j = i + 1; j < last; j++) {
+                    if (getHammingDistance(hashes[bucket[i]], hashes[bucket[j]]) <= maxDistance) {
+                        joinSets(parents, bucket[i], bucket[j]);
+                    }
+                }
+            }
+            first = last;
+        }
+    }
+
+    // Roots are the lowest index of each set, so clusters come out in order
+    std::vector<std::vector<uint32_t>> clusters;
+    std::vector<uint32_t> clusterOfRoot(hashes.size(), UINT32_MAX);
+    std::vector<uint32_t> sizes(hashes.size(), 0);
+    for (uint32_t i = 0; i < hashes.size(); i++) {
+        sizes[findRoot(parents, i)]++;
+    }
+    for (uint32_t i = 0; i < hashes.size(); i++) {
+        uint32_t root = findRoot(parents, i);
+        if (sizes[root] < 2) {
+            continue;
+        }
+        if (clusterOfRoot[root] == UINT32_MAX) {
+            clusterOfRoot[root] = clusters.size();
+            clusters.emplace_back();
+            clusters.back().reserve(sizes[root]);
+        }
+        clusters[clusterOfRoot[root]].push_back(i);
+    }
+    return clusters;
+}
+
+void hashImages(const std::vector<std::string> &paths, int width, int height, std::vector<PerceptualHash> &hashes, std::vector<uint8_t> &valid, std::atomic<uint32_t> &done) {
+    hashes.assign(paths.size(), {0, 0});
+    valid.assign(paths.size(), 0);
+    std::atomic<size_t> next{0};
+    auto work = [&]() {
+        for (size_t i = next.fetch_add(1); i < paths.size(); i = next.fetch_add(1)) {
+            SDL_Surface *thumbnail = decodeThumbnail(paths[i], width, height);
+            if (thumbnail) {
+                hashes[i] = computePerceptualHash(static_cast<const uint8_t *>(thumbnail->pixels), thumbnail->w, thumbnail->h, thumbnail->pitch);
+                valid[i] = 1;
+                SDL_FreeSurface(thumbnail);
+            }
+            done.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (int i = 1; i < PERCEPTUAL_HASH_WORKER_COUNT; i++) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
@@ -0,0 +1,139 @@
+#include <Crc32.h>
+#include <FileExporter.h>
+#include <PngWriter.h>
+#include <algorithm>
+
+#define PNG_FILTER_UP 2
+
+static void putBE32(uint8_t *data, uint32_t value) {
+    data[0] = value >> 24;
+    data[1] = value >> 16;
+    data[2] = value >> 8;
+    data[3] = value;
+}
+
+PngWriter::~PngWriter() {
+    close();
+}
+
+bool PngWriter::open(const std::string &path, uint32_t width, uint32_t height, int level) {
+    close();
+    this->path = path;
+    partPath = path + EXPORT_PART_SUFFIX;
+    this->width = width;
+    this->height = height;
+    rowsWritten = 0;
+    failed = false;
+    previousRow.assign(width * 3, 0);
+    filteredRow.resize(1 + width * 3);
+    output.resize(PNG_WRITER_CHUNK_SIZE);
+
+    if (deflateInit(&stream, level) != Z_OK) {
+        return false;
+    }
+    streamOpen = true;
+    stream.next_out = output.data();
+    stream.avail_out = output.size();
+    file = fopen(partPath.c_str(), "wb");
+    if (file == nullptr) {
+        close();
+        return false;
+    }
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    uint8_t header[13];
+    putBE32(header, width);
+    putBE32(header + 4, height);
+    header[8] = 8;  // bits per channel
+    header[9] = 2;  // RGB
+    header[10] = 0; // deflate
+    header[11] = 0; // adaptive filtering
+    header[12] = 0; // not interlaced
+    failed = fwrite(signature, sizeof(signature), 1, file) != 1 || !writeChunk("IHDR", header, sizeof(header));
+    return !failed;
+}
+
+bool PngWriter::writeRows(const uint8_t *rows, uint32_t count, size_t pitch) {
+    if (file == nullptr || failed || rowsWritten + count > height) {
+        return false;
+    }
+    size_t rowSize = width * 3;
+    for (uint32_t y = 0; y < count; y++) {
+        const uint8_t *row = rows + y * pitch;
+        uint8_t *filtered = filteredRow.data() + 1;
+        const uint8_t *previous = previousRow.data();
+        filteredRow[0] = PNG_FILTER_UP;
+        for (size_t i = 0; i < rowSize; i++) {
+            filtered[i] = row[i] - previous[i];
+        }
+        std::copy(row, row + rowSize, previousRow.begin());
+        stream.next_in = filteredRow.data();
+        stream.avail_in = filteredRow.size();
+        if (!deflateInto(Z_NO_FLUSH)) {
+            failed = true;
+            return false;
+        }
+    }
+    rowsWritten += count;
+    return true;
+}
+
+bool PngWriter::finish() {
+    if (file == nullptr) {
+        return false;
+    }
+    bool written = !failed && rowsWritten == height && deflateInto(Z_FINISH) && writeChunk("IEND", nullptr, 0);
+    written = fclose(file) == 0 && written;
+    file = nullptr;
+    if (written) {
+        // FAT cannot rename over an existing file
+        remove(path.c_str());
+        written = rename(partPath.c_str(), path.c_str()) == 0;
+    }
+    if (!written) {
+        remove(partPath.c_str());
+    }
+    close();
+    return written;
+}
+
+bool PngWriter::writeChunk(const char *type, const uint8_t *data, size_t size) {
+    uint8_t header[8];
+    putBE32(header, size);
+    std::copy(type, type + 4, header + 4);
+    uint8_t footer[4];
+    putBE32(footer, updateCrc32(updateCrc32(0, header + 4, 4), data, size));
+    return fwrite(header, sizeof(header), 1, file) == 1 && (size == 0 || fwrite(data, size, 1, file) == 1) && fwrite(footer, sizeof(footer), 1, file) == 1;
+}
+
+// Runs deflate over the pending input and writes every full output buffer
+// as one IDAT chunk, the last partial one only when finishing
+bool PngWriter::deflateInto(int flush) {
+    int result;
+    do {
+        result = deflate(&stream, flush);
+        if (result == Z_STREAM_ERROR) {
+            return false;
+        }
+        if (stream.avail_out == 0 || (result == Z_STREAM_END && stream.avail_out < output.size())) {
+            if (!writeChunk("IDAT", output.data(), output.size() - stream.avail_out)) {
+                return false;
+            }
+            stream.next_out = output.data();
+            stream.avail_out = output.size();
+        }
+    } while (flush == Z_FINISH ? result != Z_STREAM_END : stream.avail_in > 0);
+    return true;
+}
+
+void PngWriter::close() {
+    if (file) {
+        fclose(file);
+        file = nullptr;
+        remove(partPath.c_str());
+    }
+    if (streamOpen) {
+        deflateEnd(&stream);
+        streamOpen = false;
+    }
+    stream = {};
+}
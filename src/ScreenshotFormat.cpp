@@ -0,0 +1,25 @@
+#include <ScreenshotFormat.h>
+
+const char *getImageFormatExtension(ImageFormat format) {
+    switch (format) {
+        case ImageFormat::JPG:
+            return ".jpg";
+        case ImageFormat::PNG:
+            return ".png";
+        case ImageFormat::BMP:
+            return ".bmp";
+        default:
+            return "";
+    }
+}
+
+const char *getScreenshotKindSuffix(ScreenshotKind kind) {
+    switch (kind) {
+        case ScreenshotKind::TV:
+            return "_TV";
+        case ScreenshotKind::DRC:
+            return "_DRC";
+        default:
+            return "";
+    }
+}
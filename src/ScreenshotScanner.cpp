@@ -0,0 +1,168 @@
+#include <ScreenshotScanner.h>
+#include <algorithm>
+#include <cstring>
+
+ScreenshotName classifyScreenshotName(std::string_view filename) {
+    ScreenshotName result{ScreenshotKind::None, ImageFormat::Unknown, 0};
+    size_t size = filename.size();
+    // Shortest match is "_TV.jpg" with at least one character in front
+    if (size < 8 || filename[size - 4] != '.') {
+        return result;
+    }
+
+    const char *ext = filename.data() + size - 3;
+    if (ext[0] == 'j' && ext[1] == 'p' && ext[2] == 'g') {
+        result.format = ImageFormat::JPG;
+    } else if (ext[0] == 'p' && ext[1] == 'n' && ext[2] == 'g') {
+        result.format = ImageFormat::PNG;
+    } else if (ext[0] == 'b' && ext[1] == 'm' && ext[2] == 'p') {
+        result.format = ImageFormat::BMP;
+    } else {
+        return result;
+    }
+
+    // filename[size - 5] is the last letter of TV or DRC
+    const char *tag = filename.data() + size - 4;
+    if (tag[-1] == 'V' && tag[-2] == 'T' && tag[-3] == '_') {
+        result.kind = ScreenshotKind::TV;
+        result.stemLength = size - 7;
+    } else if (size >= 9 && tag[-1] == 'C' && tag[-2] == 'R' && tag[-3] == 'D' && tag[-4] == '_') {
+        result.kind = ScreenshotKind::DRC;
+        result.stemLength = size - 8;
+    } else {
+        result.format = ImageFormat::Unknown;
+    }
+    if (result.stemLength > SCREENSHOT_STEM_MAX_LENGTH) {
+        result = {ScreenshotKind::None, ImageFormat::Unknown, 0};
+    }
+    return result;
+}
+
+std::string_view PathArena::store(std::string_view text) {
+    // A fresh arena has no block to point into yet
+    if (text.empty()) {
+        return {};
+    }
+    if (blockUsed + text.size() > PATH_ARENA_BLOCK_SIZE) {
+        blocks.push_back(std::make_unique<char[]>(std::max<size_t>(text.size(), PATH_ARENA_BLOCK_SIZE)));
+        blockUsed = 0;
+    }
+    char *dst = blocks.back().get() + blockUsed;
+    memcpy(dst, text.data(), text.size());
+    // An oversized string fills its dedicated block completely
+    blockUsed = std::min<size_t>(blockUsed + text.size(), PATH_ARENA_BLOCK_SIZE);
+    return {dst, text.size()};
+}
+
+void PathArena::clear() {
+    blocks.clear();
+    blockUsed = PATH_ARENA_BLOCK_SIZE;
+}
+
+ScreenshotScanner::ScreenshotScanner(ScanProgress *progress) : progress(progress) {
+}
+
+void ScreenshotScanner::clear() {
+    arena.clear();
+    directories.clear();
+    records.clear();
+    directoryStems.clear();
+    pairs.clear();
+}
+
+void ScreenshotScanner::scan(const std::string &rootPath, DirectoryBackend backend, bool recursive) {
+    clear();
+    this->recursive = recursive;
+    createDirectoryEnumerator(backend)->enumerate(rootPath, *this);
+    pairRecords();
+}
+
+bool ScreenshotScanner::onDirectory(std::string_view path) {
+    // Enumeration is per directory, so every directory is stored exactly once
+    if (path.size() > 1 && path.back() == '/' && path[path.size() - 2] != ':') {
+        path.remove_suffix(1);
+    }
+    if (!recursive && !directories.empty()) {
+        return false;
+    }
+    // Hidden directories, like the trash, are never part of the album
+    size_t nameStart = path.rfind('/');
+    if (!directories.empty() && nameStart != std::string_view::npos && nameStart + 1 < path.size() && path[nameStart + 1] == '.') {
+        return false;
+    }
+    directories.push_back(arena.store(path));
+    currentDirectory = directories.size() - 1;
+    directoryStems.clear();
+    return true;
+}
+
+void ScreenshotScanner::onFile(std::string_view name) {
+    if (progress) {
+        progress->addFileSeen();
+    }
+    ScreenshotName screenshot = classifyScreenshotName(name);
+    if (screenshot.kind == ScreenshotKind::None) {
+        return;
+    }
+    records.push_back({currentDirectory, screenshot.kind, screenshot.format, arena.store(name.substr(0, screenshot.stemLength))});
+    // A directory's files all arrive before the next directory, so the first
+    // half of a stem seen here is a new pair
+    if (progress && directoryStems.insert(records.back().stem).second) {
+        progress->addPairFound();
+    }
+}
+
+void ScreenshotScanner::pairRecords() {
+    // Sorting puts the TV and DRC halves of a pair next to each other
+    std::sort(records.begin(), records.end(), [](const ScanRecord &a, const ScanRecord &b) {
+        if (a.directory != b.directory) {
+            return a.directory < b.directory;
+        }
+        if (a.stem != b.stem) {
+            return a.stem < b.stem;
+        }
+        return a.kind < b.kind;
+    });
+
+    pairs.reserve(records.size() / 2 + 1);
+    for (size_t i = 0; i < records.size();) {
+        const ScanRecord &first = records[i];
+        ScreenshotPair pair{first.directory, first.stem, ImageFormat::Unknown, ImageFormat::Unknown};
+        size_t j = i;
+        for (; j < records.size() && records[j].directory == first.directory && records[j].stem == first.stem; j++) {
+            if (records[j].kind == ScreenshotKind::TV) {
+                pair.tvFormat = records[j].format;
+            } else {
+                pair.drcFormat = records[j].format;
+            }
+        }
+        pairs.push_back(pair);
+        i = j;
+    }
+    records.clear();
+    directoryStems.clear();
+}
+
+const std::vector<ScreenshotPair> &ScreenshotScanner::getPairs() const {
+    return pairs;
+}
+
+std::string_view ScreenshotScanner::getDirectory(uint32_t index) const {
+    return directories[index];
+}
+
+std::string ScreenshotScanner::buildPath(const ScreenshotPair &pair, ScreenshotKind kind) const {
+    ImageFormat format = kind == ScreenshotKind::TV ? pair.tvFormat : pair.drcFormat;
+    if (format == ImageFormat::Unknown) {
+        return {};
+    }
+    std::string_view directory = directories[pair.directory];
+    std::string path;
+    path.reserve(directory.size() + pair.stem.size() + 9);
+    path.append(directory);
+    path.push_back('/');
+    path.append(pair.stem);
+    path.append(getScreenshotKindSuffix(kind));
+    path.append(getImageFormatExtension(format));
+    return path;
+}
@@ -0,0 +1,181 @@
+#include <ScrollEngine.h>
+#include <algorithm>
+#include <cmath>
+
+void ScrollEngine::setBounds(float minOffset, float maxOffset) {
+    this->minOffset = std::min(minOffset, maxOffset);
+    this->maxOffset = maxOffset;
+    offset = clampOffset(offset);
+    targetOffset = clampOffset(targetOffset);
+}
+
+void ScrollEngine::touchDown(float y, uint32_t timestamp) {
+    mode = Mode::Dragging;
+    velocity = 0.0f;
+    lastTouchY = y;
+    dragDistance = 0.0f;
+    sampleCount = 0;
+    sampleHead = 0;
+    samples[sampleHead] = {y, timestamp};
+    sampleCount = 1;
+}
+
+void ScrollEngine::touchMove(float y, uint32_t timestamp) {
+    if (mode != Mode::Dragging) {
+        return;
+    }
+    float delta = y - lastTouchY;
+    lastTouchY = y;
+    dragDistance += std::fabs(delta);
+    offset = clampOffset(offset + delta);
+
+    sampleHead = (sampleHead + 1) % SCROLL_VELOCITY_SAMPLES;
+    samples[sampleHead] = {y, timestamp};
+    sampleCount = std::min(sampleCount + 1, SCROLL_VELOCITY_SAMPLES);
+    velocity = estimateVelocity(timestamp);
+}
+
+void ScrollEngine::touchUp(uint32_t timestamp) {
+    if (mode != Mode::Dragging) {
+        return;
+    }
+    velocity = estimateVelocity(timestamp);
+    mode = std::fabs(velocity) > SCROLL_STOP_VELOCITY ? Mode::Flinging : Mode::Idle;
+    if (mode == Mode::Idle) {
+        velocity = 0.0f;
+    }
+}
+
+float ScrollEngine::estimateVelocity(uint32_t now) const {
+    // Least-squares slope over the recent samples. A finger that rested
+    // before lifting leaves no recent samples and so produces no fling.
+    float sumT = 0.0f, sumY = 0.0f, sumTT = 0.0f, sumTY = 0.0f;
+    int count = 0;
+    for (int i = 0; i < sampleCount; i++) {
+        const Sample &sample = samples[(sampleHead - i + SCROLL_VELOCITY_SAMPLES) % SCROLL_VELOCITY_SAMPLES];
+        uint32_t age = now - sample.timestamp;
+        if (age > SCROLL_VELOCITY_WINDOW) {
+            break;
+        }
+        float t = -static_cast<float>(age) / 1000.0f;
+        sumT += t;
+        sumY += sample.y;
+        sumTT += t * t;
+        sumTY += t * sample.y;
+        count++;
+    }
+    if (count < 2) {
+        return 0.0f;
+    }
+    float denominator = count * sumTT - sumT * sumT;
+    if (denominator <= 0.0f) {
+        return 0.0f;
+    }
+    return (count * sumTY - sumT * sumY) / denominator;
+}
+
+void ScrollEngine::scrollTo(float target) {
+    targetOffset = clampOffset(target);
+    velocity = 0.0f;
+    mode = Mode::Animating;
+}
+
+void ScrollEngine::jumpTo(float target) {
+    stop();
+    offset = clampOffset(target);
+    targetOffset = offset;
+}
+
+void ScrollEngine::ensureVisible(float contentTop, float contentBottom, float viewportTop, float viewportBottom) {
+    // Build on a pending animation so repeated presses accumulate
+    float target = mode == Mode::Animating ? targetOffset : offset;
+    if (contentTop + target < viewportTop) {
+        target = viewportTop - contentTop;
+    } else if (contentBottom + target > viewportBottom) {
+        target = viewportBottom - contentBottom;
+    }
+    if (target != offset) {
+        scrollTo(target);
+    }
+}
+
+void ScrollEngine::stop() {
+    mode = Mode::Idle;
+    velocity = 0.0f;
+}
+
+void ScrollEngine::update(float deltaSeconds) {
+    if (mode == Mode::Flinging) {
+        // Closed form of v' = -friction * v over the frame
+        float decay = std::exp(-SCROLL_FRICTION * deltaSeconds);
+        offset += velocity * (1.0f - decay) / SCROLL_FRICTION;
+        velocity *= decay;
+        float clamped = clampOffset(offset);
+        if (clamped != offset || std::fabs(velocity) < SCROLL_STOP_VELOCITY) {
+            offset = clamped;
+            stop();
+        }
+    } else if (mode == Mode::Animating) {
+        float previous = offset;
+        offset += (targetOffset - offset) * (1.0f - std::exp(-SCROLL_ANIMATION_RATE * deltaSeconds));
+        velocity = deltaSeconds > 0.0f ? (offset - previous) / deltaSeconds : 0.0f;
+        if (std::fabs(targetOffset - offset) < 0.5f) {
+            offset = targetOffset;
+            stop();
+        }
+    }
+}
+
+float ScrollEngine::clampOffset(float value) const {
+    return std::clamp(value, minOffset, maxOffset);
+}
+
+float ScrollEngine::getOffset() const {
+    return offset;
+}
+
+float ScrollEngine::getMinOffset() const {
+    return minOffset;
+}
+
+float ScrollEngine::getVelocity() const {
+    return velocity;
+}
+
+float ScrollEngine::getPredictedVelocity(float seconds) const {
+    switch (mode) {
+        case Mode::Flinging:
+            return velocity * std::exp(-SCROLL_FRICTION * seconds);
+        case Mode::Animating:
+            return (targetOffset - offset) * SCROLL_ANIMATION_RATE * std::exp(-SCROLL_ANIMATION_RATE * seconds);
+        case Mode::Dragging:
+            return velocity;
+        default:
+            return 0.0f;
+    }
+}
+
+float ScrollEngine::getPredictedOffset(float seconds) const {
+    switch (mode) {
+        case Mode::Flinging:
+            return clampOffset(offset + velocity * (1.0f - std::exp(-SCROLL_FRICTION * seconds)) / SCROLL_FRICTION);
+        case Mode::Animating:
+            return offset + (targetOffset - offset) * (1.0f - std::exp(-SCROLL_ANIMATION_RATE * seconds));
+        case Mode::Dragging:
+            return clampOffset(offset + velocity * seconds);
+        default:
+            return offset;
+    }
+}
+
+float ScrollEngine::getDragDistance() const {
+    return dragDistance;
+}
+
+bool ScrollEngine::isDragging() const {
+    return mode == Mode::Dragging;
+}
+
+bool ScrollEngine::isMoving() const {
+    return mode == Mode::Flinging || mode == Mode::Animating;
+}
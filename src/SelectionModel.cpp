@@ -0,0 +1,85 @@
+#include <SelectionModel.h>
+#include <utility>
+
+// Bits [first, last] of a word, both within 0..63
+static uint64_t wordMask(size_t first, size_t last) {
+    uint64_t high = last == 63 ? ~0ULL : (1ULL << (last + 1)) - 1;
+    return high & ~((1ULL << first) - 1);
+}
+
+void SelectionModel::resize(size_t size) {
+    bitCount = size;
+    words.assign((size + 63) / 64, 0);
+    selectedCount = 0;
+}
+
+void SelectionModel::set(size_t index, bool selected) {
+    if (index >= bitCount || isSelected(index) == selected) {
+        return;
+    }
+    words[index / 64] ^= 1ULL << (index % 64);
+    if (selected) {
+        selectedCount++;
+    } else {
+        selectedCount--;
+    }
+}
+
+void SelectionModel::toggle(size_t index) {
+    if (index < bitCount) {
+        set(index, !isSelected(index));
+    }
+}
+
+void SelectionModel::setRange(size_t first, size_t last, bool selected) {
+    if (first > last) {
+        std::swap(first, last);
+    }
+    if (first >= bitCount) {
+        return;
+    }
+    if (last >= bitCount) {
+        last = bitCount - 1;
+    }
+    for (size_t word = first / 64; word <= last / 64; word++) {
+        size_t low = word == first / 64 ? first % 64 : 0;
+        size_t high = word == last / 64 ? last % 64 : 63;
+        uint64_t mask = wordMask(low, high);
+        uint64_t updated = selected ? words[word] | mask : words[word] & ~mask;
+        selectedCount += std::popcount(updated);
+        selectedCount -= std::popcount(words[word]);
+        words[word] = updated;
+    }
+}
+
+bool SelectionModel::isRangeSelected(size_t first, size_t last) const {
+    if (first > last) {
+        std::swap(first, last);
+    }
+    if (last >= bitCount) {
+        return false;
+    }
+    for (size_t word = first / 64; word <= last / 64; word++) {
+        size_t low = word == first / 64 ? first % 64 : 0;
+        size_t high = word == last / 64 ? last % 64 : 63;
+        uint64_t mask = wordMask(low, high);
+        if ((words[word] & mask) != mask) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SelectionModel::selectAll() {
+    if (bitCount > 0) {
+        setRange(0, bitCount - 1, true);
+    }
+}
+
+void SelectionModel::clear() {
+    if (selectedCount == 0) {
+        return;
+    }
+    words.assign(words.size(), 0);
+    selectedCount = 0;
+}
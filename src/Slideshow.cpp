@@ -0,0 +1,235 @@
+#include <ImagePairScreen.h>
+#include <SDL2/SDL_image.h>
+#include <Slideshow.h>
+#include <algorithm>
+#include <cstdlib>
+#ifdef __WIIU__
+#include <coreinit/thread.h>
+#endif
+
+Slideshow::Slideshow(SDL_Renderer *renderer, std::vector<SlideSource> sources, uint32_t first)
+    : renderer(renderer), sources(std::move(sources)), current(first), previous(first) {
+    slides.reserve(SLIDESHOW_DECODE_AHEAD + 2);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        updateWindow();
+    }
+    for (int i = 0; i < SLIDESHOW_WORKER_COUNT; i++) {
+        workers.emplace_back(&Slideshow::workerLoop, this);
+    }
+}
+
+Slideshow::~Slideshow() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    condition.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    for (auto &slide : slides) {
+        SDL_FreeSurface(slide.surface);
+        if (slide.texture) {
+            SDL_DestroyTexture(slide.texture);
+        }
+    }
+}
+
+uint32_t Slideshow::getSource(int64_t number) const {
+    int64_t count = sources.size();
+    return ((number % count) + count) % count;
+}
+
+Slideshow::Slide *Slideshow::findSlide(int64_t number) {
+    for (auto &slide : slides) {
+        if (slide.number == number) {
+            return &slide;
+        }
+    }
+    return nullptr;
+}
+
+bool Slideshow::isInWindow(int64_t number) const {
+    int64_t ahead = (number - current) * direction;
+    return number == previous || number == current || (ahead > 0 && ahead <= windowAhead);
+}
+
+void Slideshow::updateWindow() {
+    int pending = 0;
+    windowAhead = 0;
+    while (pending < SLIDESHOW_DECODE_AHEAD && windowAhead + 1 < static_cast<int64_t>(sources.size())) {
+        windowAhead++;
+        const Slide *slide = findSlide(current + windowAhead * direction);
+        if (slide == nullptr || slide->state != SlideState::Failed) {
+            pending++;
+        }
+    }
+    exhausted = pending == 0;
+    windowStale = false;
+
+    // A slide being decoded is left to its worker, which drops it afterwards
+    for (auto it = slides.begin(); it != slides.end();) {
+        if (!isInWindow(it->number) && it->state != SlideState::Decoding) {
+            SDL_FreeSurface(it->surface);
+            if (it->texture) {
+                SDL_DestroyTexture(it->texture);
+            }
+            it = slides.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    bool queued = false;
+    for (int64_t number = current; (number - current) * direction <= windowAhead; number += direction) {
+        if (findSlide(number) == nullptr) {
+            slides.push_back({number, SlideState::Queued, nullptr, nullptr});
+            queued = true;
+        }
+    }
+    if (queued) {
+        condition.notify_all();
+    }
+}
+
+void Slideshow::workerLoop() {
+#ifdef __WIIU__
+    OSSetThreadPriority(OSGetCurrentThread(), SLIDESHOW_THREAD_PRIORITY);
+#endif
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        // The slide nearest to the current one goes first
+        Slide *next = nullptr;
+        condition.wait(lock, [&] {
+            next = nullptr;
+            for (auto &slide : slides) {
+                if (slide.state == SlideState::Queued && (next == nullptr || std::abs(slide.number - current) < std::abs(next->number - current))) {
+                    next = &slide;
+                }
+            }
+            return stopping || next != nullptr;
+        });
+        if (stopping) {
+            return;
+        }
+        int64_t number = next->number;
+        next->state = SlideState::Decoding;
+        std::string path = sources[getSource(number)].path;
+        lock.unlock();
+
+        SDL_Surface *surface = IMG_Load(path.c_str());
+
+        lock.lock();
+        // The window never drops a slide being decoded, so it is still there,
+        // but it may have fallen out of the window meanwhile
+        auto slide = std::find_if(slides.begin(), slides.end(), [&](const Slide &slide) { return slide.number == number; });
+        if (isInWindow(number)) {
+            slide->surface = surface;
+            slide->state = surface ? SlideState::Decoded : SlideState::Failed;
+            // The render thread lays the window out again, it owns the textures
+            windowStale = windowStale || surface == nullptr;
+        } else {
+            SDL_FreeSurface(surface);
+            slides.erase(slide);
+        }
+    }
+}
+
+void Slideshow::update(Uint32 now) {
+    std::lock_guard<std::mutex> lock(mutex);
+    // One upload per frame keeps the frame time even
+    for (auto &slide : slides) {
+        if (slide.state == SlideState::Decoded) {
+            slide.texture = SDL_CreateTextureFromSurface(renderer, slide.surface);
+            SDL_FreeSurface(slide.surface);
+            slide.surface = nullptr;
+            slide.state = slide.texture ? SlideState::Resident : SlideState::Failed;
+            if (slide.texture) {
+                SDL_SetTextureBlendMode(slide.texture, SDL_BLENDMODE_BLEND);
+            } else {
+                windowStale = true;
+            }
+            break;
+        }
+    }
+    if (windowStale) {
+        updateWindow();
+    }
+
+    if (previous != current && now - fadeStart >= SLIDESHOW_FADE_MS) {
+        previous = current;
+        updateWindow();
+    }
+    Slide *shown = findSlide(current);
+    if (shown && (shown->state == SlideState::Resident || shown->state == SlideState::Failed) && slideStart == 0) {
+        // The first slide's time starts once it is up
+        slideStart = now;
+    }
+    bool due = stepRequested || (!paused && slideStart != 0 && now - slideStart >= SLIDESHOW_INTERVAL_MS);
+    if (!due || previous != current) {
+        return;
+    }
+    // Slides that failed to decode are passed over, one still decoding holds the show
+    int64_t next = current + direction;
+    Slide *slide = findSlide(next);
+    while (slide && slide->state == SlideState::Failed) {
+        next += direction;
+        slide = findSlide(next);
+    }
+    if (slide == nullptr || slide->state != SlideState::Resident) {
+        return;
+    }
+    previous = current;
+    current = next;
+    fadeStart = now;
+    slideStart = now;
+    stepRequested = false;
+    direction = 1;
+    updateWindow();
+}
+
+void Slideshow::render(Uint32 now) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const Slide *shown = findSlide(current);
+    if (previous == current) {
+        renderSlide(shown, 255);
+        return;
+    }
+    float fade = std::min((now - fadeStart) / static_cast<float>(SLIDESHOW_FADE_MS), 1.0f);
+    renderSlide(findSlide(previous), 255);
+    renderSlide(shown, static_cast<uint8_t>(fade * 255));
+}
+
+void Slideshow::renderSlide(const Slide *slide, uint8_t alpha) {
+    if (slide == nullptr || slide->texture == nullptr) {
+        return;
+    }
+    ImageInfo info{};
+    int width, height;
+    SDL_QueryTexture(slide->texture, nullptr, nullptr, &width, &height);
+    info.width = width;
+    info.height = height;
+    info.orientation = sources[getSource(slide->number)].orientation;
+    SDL_SetTextureAlphaMod(slide->texture, alpha);
+    renderFittedImage(renderer, slide->texture, &info, {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT});
+    SDL_SetTextureAlphaMod(slide->texture, 255);
+}
+
+void Slideshow::step(int direction) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (previous != current) {
+        return;
+    }
+    this->direction = direction;
+    stepRequested = true;
+    updateWindow();
+}
+
+void Slideshow::togglePaused() {
+    std::lock_guard<std::mutex> lock(mutex);
+    paused = !paused;
+}
+
+bool Slideshow::isWaiting(Uint32 now) const {
+    return (stepRequested || (!paused && slideStart != 0 && now - slideStart >= SLIDESHOW_INTERVAL_MS)) && previous == current && !exhausted;
+}
@@ -0,0 +1,33 @@
+#include <CaptureTime.h>
+#include <SortOrder.h>
+#include <algorithm>
+
+const char *getSortModeName(SortMode mode) {
+    switch (mode) {
+        case SortMode::NewestFirst:
+            return "Newest first";
+        case SortMode::OldestFirst:
+            return "Oldest first";
+        case SortMode::ByGame:
+            return "By game";
+        default:
+            return "";
+    }
+}
+
+SortMode getNextSortMode(SortMode mode) {
+    return static_cast<SortMode>((static_cast<int>(mode) + 1) % static_cast<int>(SortMode::Count));
+}
+
+uint64_t makeCaptureSortKey(uint64_t captureTime, SortMode mode) {
+    if (captureTime == CAPTURE_TIME_UNKNOWN) {
+        return UINT64_MAX;
+    }
+    return mode == SortMode::OldestFirst ? captureTime : UINT64_MAX - 1 - captureTime;
+}
+
+void sortByKeys(std::vector<SortKey> &keys) {
+    std::sort(keys.begin(), keys.end(), [](const SortKey &a, const SortKey &b) {
+        return a.key != b.key ? a.key < b.key : a.tie < b.tie;
+    });
+}
@@ -0,0 +1,170 @@
+#include <PngWriter.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <StorageOptimizer.h>
+#include <cstdio>
+#include <sys/stat.h>
+#include <thread>
+
+namespace {
+
+// One half of a pair on its way from the original to the converted file
+struct ConvertedFile {
+    std::string source;
+    std::string target;
+    std::string temp;
+    uint64_t sourceSize;
+    uint64_t targetSize;
+};
+
+} // namespace
+
+static uint64_t getFileSize(const std::string &path) {
+    struct stat st {};
+    return stat(path.c_str(), &st) == 0 ? st.st_size : 0;
+}
+
+static bool fileExists(const std::string &path) {
+    struct stat st {};
+    return stat(path.c_str(), &st) == 0;
+}
+
+static ImageFormat getFileFormat(const std::string &path) {
+    return path.empty() ? ImageFormat::Unknown : classifyScreenshotName(path).format;
+}
+
+bool isOptimizable(ImageFormat format) {
+    return format == ImageFormat::PNG || format == ImageFormat::BMP;
+}
+
+static bool encodeFile(const std::string &source, const std::string &temp, OptimizeMode mode) {
+    SDL_Surface *decoded = IMG_Load(source.c_str());
+    if (decoded && decoded->format->format != SDL_PIXELFORMAT_RGB24) {
+        SDL_Surface *converted = SDL_ConvertSurfaceFormat(decoded, SDL_PIXELFORMAT_RGB24, 0);
+        SDL_FreeSurface(decoded);
+        decoded = converted;
+    }
+    if (!decoded) {
+        return false;
+    }
+    bool encoded;
+    if (mode == OptimizeMode::Jpeg) {
+        encoded = IMG_SaveJPG(decoded, temp.c_str(), OPTIMIZE_JPEG_QUALITY) == 0;
+    } else {
+        PngWriter writer;
+        encoded = writer.open(temp, decoded->w, decoded->h, OPTIMIZE_PNG_LEVEL) &&
+                  writer.writeRows(static_cast<const uint8_t *>(decoded->pixels), decoded->h, decoded->pitch) && writer.finish();
+    }
+    SDL_FreeSurface(decoded);
+    return encoded;
+}
+
+// Swaps every converted half in, or none of them. An original with the
+// target's name is moved aside first, FAT cannot rename over it.
+static bool commitFiles(std::vector<ConvertedFile> &files) {
+    size_t committed = 0;
+    for (; committed < files.size(); committed++) {
+        ConvertedFile &file = files[committed];
+        bool inPlace = file.source == file.target;
+        if (inPlace && rename(file.source.c_str(), (file.source + OPTIMIZE_BACKUP_SUFFIX).c_str()) != 0) {
+            break;
+        }
+        if (rename(file.temp.c_str(), file.target.c_str()) != 0) {
+            if (inPlace) {
+                rename((file.source + OPTIMIZE_BACKUP_SUFFIX).c_str(), file.source.c_str());
+            }
+            break;
+        }
+    }
+    if (committed < files.size()) {
+        while (committed-- > 0) {
+            ConvertedFile &file = files[committed];
+            if (file.source == file.target) {
+                remove(file.target.c_str());
+                rename((file.source + OPTIMIZE_BACKUP_SUFFIX).c_str(), file.source.c_str());
+            } else {
+                remove(file.target.c_str());
+            }
+        }
+        return false;
+    }
+    for (const auto &file : files) {
+        remove(file.source == file.target ? (file.source + OPTIMIZE_BACKUP_SUFFIX).c_str() : file.source.c_str());
+    }
+    return true;
+}
+
+static OptimizeResult optimizePair(const OptimizeJob &job, OptimizeMode mode, OptimizeProgress &progress) {
+    OptimizeResult result{getFileFormat(job.pathTV), getFileFormat(job.pathDRC), false};
+    ImageFormat target = mode == OptimizeMode::Jpeg ? ImageFormat::JPG : ImageFormat::PNG;
+    std::vector<ConvertedFile> files;
+    for (const std::string *path : {&job.pathTV, &job.pathDRC}) {
+        if (path->empty() || !isOptimizable(getFileFormat(*path))) {
+            continue;
+        }
+        ConvertedFile file;
+        file.source = *path;
+        file.target = path->substr(0, path->rfind('.')) + getImageFormatExtension(target);
+        file.temp = file.target + OPTIMIZE_TEMP_SUFFIX;
+        file.sourceSize = getFileSize(file.source);
+        file.targetSize = 0;
+        files.push_back(std::move(file));
+    }
+
+    uint64_t sourceSize = 0;
+    uint64_t targetSize = 0;
+    bool encoded = !files.empty();
+    for (auto &file : files) {
+        // Another file already has the converted name, leave the pair alone
+        if (file.source != file.target && fileExists(file.target)) {
+            encoded = false;
+        }
+        encoded = encoded && encodeFile(file.source, file.temp, mode);
+        file.targetSize = encoded ? getFileSize(file.temp) : 0;
+        sourceSize += file.sourceSize;
+        targetSize += file.targetSize;
+    }
+    if (encoded && targetSize < sourceSize && commitFiles(files)) {
+        if (!job.pathTV.empty() && isOptimizable(result.tvFormat)) {
+            result.tvFormat = target;
+        }
+        if (!job.pathDRC.empty() && isOptimizable(result.drcFormat)) {
+            result.drcFormat = target;
+        }
+        result.optimized = true;
+        progress.bytesRead.fetch_add(sourceSize, std::memory_order_relaxed);
+        progress.bytesWritten.fetch_add(targetSize, std::memory_order_relaxed);
+    } else {
+        for (const auto &file : files) {
+            remove(file.temp.c_str());
+        }
+        // Already as small as it gets is not a failure
+        if (!encoded) {
+            progress.pairsFailed.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    progress.pairsDone.fetch_add(1, std::memory_order_relaxed);
+    return result;
+}
+
+void optimizePairs(const std::vector<OptimizeJob> &jobs, OptimizeMode mode, std::vector<OptimizeResult> &results, OptimizeProgress &progress) {
+    results.resize(jobs.size());
+    for (size_t i = 0; i < jobs.size(); i++) {
+        results[i] = {getFileFormat(jobs[i].pathTV), getFileFormat(jobs[i].pathDRC), false};
+    }
+    std::atomic<size_t> nextJob{0};
+    auto work = [&] {
+        size_t job;
+        while (!progress.cancelled.load(std::memory_order_relaxed) && (job = nextJob.fetch_add(1, std::memory_order_relaxed)) < jobs.size()) {
+            results[job] = optimizePair(jobs[job], mode, progress);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (int i = 1; i < OPTIMIZE_WORKER_COUNT; i++) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
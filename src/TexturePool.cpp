@@ -0,0 +1,71 @@
+#include <TexturePool.h>
+#include <cstring>
+
+TexturePool::TexturePool(SDL_Renderer *renderer, int width, int height, int capacity) : width(width), height(height) {
+    textures.reserve(capacity);
+    for (int i = 0; i < capacity; i++) {
+        SDL_Texture *texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING, width, height);
+        if (!texture) {
+            break;
+        }
+        textures.push_back(texture);
+    }
+    // Handed out from the back, so the first slots go first
+    for (int i = static_cast<int>(textures.size()) - 1; i >= 0; i--) {
+        freeList.push_back(i);
+    }
+}
+
+TexturePool::~TexturePool() {
+    for (SDL_Texture *texture : textures) {
+        SDL_DestroyTexture(texture);
+    }
+}
+
+int TexturePool::acquire() {
+    if (freeList.empty()) {
+        return -1;
+    }
+    int slot = freeList.back();
+    freeList.pop_back();
+    return slot;
+}
+
+void TexturePool::release(int slot) {
+    if (slot >= 0 && slot < static_cast<int>(textures.size())) {
+        freeList.push_back(slot);
+    }
+}
+
+SDL_Texture *TexturePool::getTexture(int slot) const {
+    return textures[slot];
+}
+
+bool TexturePool::upload(int slot, SDL_Surface *surface) {
+    SDL_Texture *texture = textures[slot];
+    if (!surface || surface->w != width || surface->h != height || surface->format->format != SDL_PIXELFORMAT_RGBA32) {
+        return false;
+    }
+
+    void *pixels;
+    int pitch;
+    if (SDL_LockTexture(texture, nullptr, &pixels, &pitch) != 0) {
+        return false;
+    }
+    const uint8_t *src = static_cast<const uint8_t *>(surface->pixels);
+    uint8_t *dst = static_cast<uint8_t *>(pixels);
+    size_t rowBytes = static_cast<size_t>(width) * 4;
+    if (pitch == surface->pitch) {
+        memcpy(dst, src, rowBytes + static_cast<size_t>(pitch) * (height - 1));
+    } else {
+        for (int y = 0; y < height; y++) {
+            memcpy(dst + static_cast<size_t>(y) * pitch, src + static_cast<size_t>(y) * surface->pitch, rowBytes);
+        }
+    }
+    SDL_UnlockTexture(texture);
+    return true;
+}
+
+size_t TexturePool::getAvailable() const {
+    return freeList.size();
+}
@@ -0,0 +1,105 @@
+#include <TextureUploadQueue.h>
+#include <algorithm>
+
+#define UPLOAD_DONE UINT32_MAX
+
+static size_t getSurfaceBytes(const SDL_Surface *surface) {
+    return surface ? static_cast<size_t>(surface->pitch) * surface->h : 0;
+}
+
+TextureUploadQueue::~TextureUploadQueue() {
+    clear();
+}
+
+void TextureUploadQueue::push(const ThumbnailResult &result) {
+    if (result.index >= queued.size()) {
+        queued.resize(result.index + 1);
+    }
+    queued[result.index] = 1;
+    pending.push_back(result);
+}
+
+uint64_t TextureUploadQueue::elapsedMicros(uint64_t since) const {
+    return (SDL_GetPerformanceCounter() - since) * 1000000 / SDL_GetPerformanceFrequency();
+}
+
+void TextureUploadQueue::beginFrame() {
+    uint64_t now = SDL_GetPerformanceCounter();
+    if (frameStart != 0) {
+        uint64_t interval = (now - frameStart) * 1000000 / SDL_GetPerformanceFrequency();
+        // Halve the budget after a missed vsync, win it back slowly
+        if (interval > UPLOAD_FRAME_TARGET_US * 3 / 2) {
+            backoff = std::max(backoff * 0.5f, 0.125f);
+        } else {
+            backoff = std::min(backoff + 0.05f, 1.0f);
+        }
+    }
+    frameStart = now;
+    uploadMicros = 0;
+}
+
+void TextureUploadQueue::endFrame() {
+    if (frameStart == 0) {
+        return;
+    }
+    float work = static_cast<float>(elapsedMicros(frameStart) - uploadMicros);
+    frameWorkEstimate += (work - frameWorkEstimate) * 0.1f;
+}
+
+uint32_t TextureUploadQueue::getBudgetMicros() const {
+    float available = UPLOAD_FRAME_TARGET_US - UPLOAD_SAFETY_US - frameWorkEstimate;
+    return static_cast<uint32_t>(std::max(available * backoff, static_cast<float>(UPLOAD_MIN_US)));
+}
+
+int TextureUploadQueue::process(const PriorityFunction &priority, const UploadFunction &upload) {
+    if (pending.empty()) {
+        return 0;
+    }
+
+    order.clear();
+    for (size_t i = 0; i < pending.size(); i++) {
+        float value = priority(pending[i].index);
+        if (value < 0.0f) {
+            SDL_FreeSurface(pending[i].surfaceTV);
+            SDL_FreeSurface(pending[i].surfaceDRC);
+            queued[pending[i].index] = 0;
+            pending[i].index = UPLOAD_DONE;
+            continue;
+        }
+        order.emplace_back(value, i);
+    }
+    std::sort(order.begin(), order.end());
+
+    uint32_t budget = getBudgetMicros();
+    uint64_t start = SDL_GetPerformanceCounter();
+    size_t bytes = 0;
+    int uploaded = 0;
+    for (const auto &[value, i] : order) {
+        if (uploaded > 0 && (bytes >= UPLOAD_MAX_BYTES || elapsedMicros(start) >= budget)) {
+            break;
+        }
+        bytes += getSurfaceBytes(pending[i].surfaceTV) + getSurfaceBytes(pending[i].surfaceDRC);
+        upload(pending[i]);
+        queued[pending[i].index] = 0;
+        pending[i].index = UPLOAD_DONE;
+        uploaded++;
+    }
+    uploadMicros += elapsedMicros(start);
+
+    // Dropped and uploaded entries were marked done, the rest carries over
+    pending.erase(std::remove_if(pending.begin(), pending.end(), [](const ThumbnailResult &result) { return result.index == UPLOAD_DONE; }), pending.end());
+    return uploaded;
+}
+
+void TextureUploadQueue::clear() {
+    for (auto &result : pending) {
+        SDL_FreeSurface(result.surfaceTV);
+        SDL_FreeSurface(result.surfaceDRC);
+        queued[result.index] = 0;
+    }
+    pending.clear();
+}
+
+size_t TextureUploadQueue::size() const {
+    return pending.size();
+}
@@ -0,0 +1,182 @@
+#include <SDL2/SDL_image.h>
+#include <ThumbnailScheduler.h>
+#include <algorithm>
+#include <cmath>
+
+ThumbnailViewport computeThumbnailViewport(float rowZeroTop, float predictedRowZeroTop, float rowPitch, float tileHeight, float viewportTop, float viewportBottom, int rowCount, float velocity) {
+    ThumbnailViewport viewport{};
+    int lastRow = std::max(rowCount - 1, 0);
+    auto firstRowAt = [&](float top) { return std::clamp(static_cast<int>(std::ceil((viewportTop - tileHeight - top) / rowPitch)), 0, lastRow); };
+    auto lastRowAt = [&](float top) { return std::clamp(static_cast<int>(std::floor((viewportBottom - top) / rowPitch)), 0, lastRow); };
+
+    viewport.firstVisibleRow = firstRowAt(rowZeroTop);
+    viewport.lastVisibleRow = lastRowAt(rowZeroTop);
+    // Content moving up (negative velocity) brings later rows into view
+    viewport.direction = velocity < 0.0f ? 1 : (velocity > 0.0f ? -1 : 0);
+
+    int ahead = THUMBNAIL_PREFETCH_AHEAD;
+    int behind = viewport.direction == 0 ? THUMBNAIL_PREFETCH_AHEAD : THUMBNAIL_PREFETCH_BEHIND;
+    int predictedFirst = firstRowAt(predictedRowZeroTop);
+    int predictedLast = lastRowAt(predictedRowZeroTop);
+    if (viewport.direction >= 0) {
+        viewport.firstPrefetchRow = std::max(std::min(viewport.firstVisibleRow, predictedFirst) - behind, 0);
+        viewport.lastPrefetchRow = std::min(std::max(viewport.lastVisibleRow, predictedLast) + ahead, lastRow);
+    } else {
+        viewport.firstPrefetchRow = std::max(std::min(viewport.firstVisibleRow, predictedFirst) - ahead, 0);
+        viewport.lastPrefetchRow = std::min(std::max(viewport.lastVisibleRow, predictedLast) + behind, lastRow);
+    }
+    return viewport;
+}
+
+float getThumbnailPriority(int row, const ThumbnailViewport &viewport) {
+    float centre = (viewport.firstVisibleRow + viewport.lastVisibleRow) * 0.5f;
+    float distance = std::fabs(row - centre);
+    if (row >= viewport.firstVisibleRow && row <= viewport.lastVisibleRow) {
+        return distance;
+    }
+    bool ahead = (viewport.direction > 0 && row > centre) || (viewport.direction < 0 && row < centre);
+    bool behind = (viewport.direction > 0 && row < centre) || (viewport.direction < 0 && row > centre);
+    float bias = ahead ? 0.5f : (behind ? 2.0f : 1.0f);
+    return 1000.0f + distance * bias;
+}
+
+ThumbnailScheduler::ThumbnailScheduler(int width, int height, ScanProgress *progress) : width(width), height(height), progress(progress) {
+    for (int i = 0; i < THUMBNAIL_WORKER_COUNT; i++) {
+        workers.emplace_back(&ThumbnailScheduler::workerLoop, this);
+    }
+}
+
+ThumbnailScheduler::~ThumbnailScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        pending.clear();
+    }
+    condition.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    for (auto &result : completed) {
+        SDL_FreeSurface(result.surfaceTV);
+        SDL_FreeSurface(result.surfaceDRC);
+    }
+}
+
+void ThumbnailScheduler::schedule(const std::vector<ThumbnailRequest> &requests, const PathProvider &paths) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Cancel queued jobs that fell out of the window, reprioritize the rest
+    std::vector<Job> kept;
+    kept.reserve(requests.size());
+    for (auto &job : pending) {
+        auto it = std::find_if(requests.begin(), requests.end(), [&](const ThumbnailRequest &request) { return request.index == job.index; });
+        if (it == requests.end()) {
+            active.erase(job.index);
+        } else {
+            job.priority = it->priority;
+            kept.push_back(std::move(job));
+        }
+    }
+    pending = std::move(kept);
+
+    for (const auto &request : requests) {
+        if (active.insert(request.index).second) {
+            Job job{request.index, request.priority, {}, {}};
+            paths(request.index, job.pathTV, job.pathDRC);
+            pending.push_back(std::move(job));
+        }
+    }
+    if (!pending.empty()) {
+        condition.notify_all();
+    }
+}
+
+void ThumbnailScheduler::collect(std::vector<ThumbnailResult> &results) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &result : completed) {
+        active.erase(result.index);
+        results.push_back(result);
+    }
+    completed.clear();
+}
+
+void ThumbnailScheduler::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.clear();
+    for (auto &result : completed) {
+        SDL_FreeSurface(result.surfaceTV);
+        SDL_FreeSurface(result.surfaceDRC);
+    }
+    completed.clear();
+    active.clear();
+    epoch++;
+}
+
+void ThumbnailScheduler::waitUntilIdle() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return running == 0; });
+}
+
+void ThumbnailScheduler::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        condition.wait(lock, [this] { return stopping || !pending.empty(); });
+        if (stopping) {
+            return;
+        }
+
+        // The window is a few dozen tiles at most, a linear scan beats
+        // keeping a heap valid while priorities change every frame
+        auto best = std::min_element(pending.begin(), pending.end(), [](const Job &a, const Job &b) { return a.priority < b.priority; });
+        Job job = std::move(*best);
+        pending.erase(best);
+        uint32_t jobEpoch = epoch;
+        running++;
+        lock.unlock();
+
+        ThumbnailResult result{job.index, decodeThumbnail(job.pathTV, width, height), decodeThumbnail(job.pathDRC, width, height), {0, 0}, false};
+        // The pixels are at hand already, hashing them here saves decoding
+        // the image again when looking for similar screenshots
+        SDL_Surface *hashSource = job.pathTV.empty() ? result.surfaceDRC : result.surfaceTV;
+        if (hashSource) {
+            result.hash = computePerceptualHash(static_cast<const uint8_t *>(hashSource->pixels), hashSource->w, hashSource->h, hashSource->pitch);
+            result.hashed = true;
+        }
+        if (progress) {
+            progress->addThumbnailDecoded();
+        }
+
+        lock.lock();
+        if (jobEpoch == epoch && !stopping) {
+            completed.push_back(result);
+        } else {
+            SDL_FreeSurface(result.surfaceTV);
+            SDL_FreeSurface(result.surfaceDRC);
+        }
+        if (--running == 0) {
+            idle.notify_all();
+        }
+    }
+}
+
+SDL_Surface *decodeThumbnail(const std::string &path, int width, int height) {
+    if (path.empty()) {
+        return nullptr;
+    }
+    SDL_Surface *decoded = IMG_Load(path.c_str());
+    if (!decoded) {
+        return nullptr;
+    }
+    SDL_Surface *converted = SDL_ConvertSurfaceFormat(decoded, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(decoded);
+    if (!converted) {
+        return nullptr;
+    }
+    SDL_Surface *thumbnail = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_RGBA32);
+    if (thumbnail && SDL_SoftStretchLinear(converted, nullptr, thumbnail, nullptr) != 0) {
+        SDL_FreeSurface(thumbnail);
+        thumbnail = nullptr;
+    }
+    SDL_FreeSurface(converted);
+    return thumbnail;
+}
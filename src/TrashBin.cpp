@@ -0,0 +1,158 @@
+#include <TrashBin.h>
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#ifdef __WIIU__
+#include <coreinit/thread.h>
+#endif
+
+TrashBin::TrashBin(const std::string &rootPath) {
+    trashPath = rootPath;
+    if (!trashPath.empty() && trashPath.back() != '/') {
+        trashPath.push_back('/');
+    }
+    trashPath.append(TRASH_DIRECTORY_NAME);
+
+    std::error_code ec;
+    std::filesystem::create_directories(trashPath, ec);
+    // Whatever is still here was deleted in an earlier run
+    for (std::filesystem::directory_iterator it(trashPath, ec), end; !ec && it != end; it.increment(ec)) {
+        purgeable.push_back(it->path().string());
+    }
+
+    // Keeps names unique against leftovers the purger has not reached yet
+    char prefix[16];
+    snprintf(prefix, sizeof(prefix), "%08lx", static_cast<unsigned long>(std::time(nullptr)));
+    namePrefix = prefix;
+
+    purger = std::thread(&TrashBin::purgeLoop, this);
+}
+
+TrashBin::~TrashBin() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    purger.join();
+}
+
+void TrashBin::beginBatch() {
+    if (lastBatch.empty()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto &file : lastBatch) {
+            purgeable.push_back(std::move(file.trashPath));
+        }
+    }
+    lastBatch.clear();
+    groupCount = 0;
+    wake.notify_one();
+}
+
+bool TrashBin::moveToTrash(const std::vector<std::string> &paths) {
+    size_t batchStart = lastBatch.size();
+    for (const auto &path : paths) {
+        std::string name = std::filesystem::path(path).filename().string();
+        char counter[16];
+        snprintf(counter, sizeof(counter), "-%u-", static_cast<unsigned>(nameCounter++));
+        std::string destination = trashPath + "/" + namePrefix + counter + name;
+
+        std::error_code ec;
+        std::filesystem::rename(path, destination, ec);
+        if (ec) {
+            // Put back what this call already moved
+            while (lastBatch.size() > batchStart) {
+                std::filesystem::rename(lastBatch.back().trashPath, lastBatch.back().originalPath, ec);
+                lastBatch.pop_back();
+            }
+            return false;
+        }
+        lastBatch.push_back({path, std::move(destination), groupCount});
+    }
+    groupCount++;
+    return true;
+}
+
+bool TrashBin::canUndo() const {
+    return !lastBatch.empty();
+}
+
+bool TrashBin::undoLastBatch(std::vector<uint32_t> &restored) {
+    restored.clear();
+    std::vector<TrashedFile> remaining;
+    // Newest first; the files of a group are next to each other
+    size_t end = lastBatch.size();
+    while (end > 0) {
+        size_t begin = end - 1;
+        while (begin > 0 && lastBatch[begin - 1].group == lastBatch[end - 1].group) {
+            begin--;
+        }
+        std::error_code ec;
+        size_t moved = begin;
+        while (moved < end && (std::filesystem::rename(lastBatch[moved].trashPath, lastBatch[moved].originalPath, ec), !ec)) {
+            moved++;
+        }
+        if (moved == end) {
+            restored.push_back(lastBatch[begin].group);
+        } else {
+            // Half a pair back in the folder is worse than none
+            while (moved > begin) {
+                moved--;
+                std::filesystem::rename(lastBatch[moved].originalPath, lastBatch[moved].trashPath, ec);
+            }
+            for (size_t i = end; i > begin; i--) {
+                remaining.push_back(std::move(lastBatch[i - 1]));
+            }
+        }
+        end = begin;
+    }
+    std::reverse(restored.begin(), restored.end());
+    std::reverse(remaining.begin(), remaining.end());
+
+    groupCount = 0;
+    for (size_t i = 0; i < remaining.size(); groupCount++) {
+        uint32_t group = remaining[i].group;
+        for (; i < remaining.size() && remaining[i].group == group; i++) {
+            remaining[i].group = groupCount;
+        }
+    }
+    lastBatch = std::move(remaining);
+    return lastBatch.empty();
+}
+
+void TrashBin::setIdle(bool idle) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (this->idle == idle) {
+            return;
+        }
+        this->idle = idle;
+    }
+    if (idle) {
+        wake.notify_one();
+    }
+}
+
+void TrashBin::purgeLoop() {
+#ifdef __WIIU__
+    OSSetThreadPriority(OSGetCurrentThread(), TRASH_PURGE_THREAD_PRIORITY);
+#endif
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || (idle && !purgeable.empty()); });
+        if (stopping) {
+            return;
+        }
+        // One file at a time, so going busy again stops the purge quickly
+        std::string path = std::move(purgeable.back());
+        purgeable.pop_back();
+        lock.unlock();
+        std::error_code ec;
+        std::filesystem::remove_all(path, ec);
+        lock.lock();
+    }
+}
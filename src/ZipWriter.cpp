@@ -0,0 +1,261 @@
+#include <BlockPipeline.h>
+#include <CaptureTime.h>
+#include <Crc32.h>
+#include <ZipWriter.h>
+#include <cstdio>
+#include <memory>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+#define ZIP_LOCAL_HEADER_SIGNATURE   0x04034b50
+#define ZIP_CENTRAL_HEADER_SIGNATURE 0x02014b50
+#define ZIP_END_SIGNATURE            0x06054b50
+#define ZIP_VERSION                  10     // 1.0, enough for stored entries
+#define ZIP_FLAGS                    0x0800 // UTF-8 names
+#define ZIP_METHOD_STORE             0
+#define ZIP_LOCAL_CRC_OFFSET         14     // CRC and both sizes in the local header
+
+namespace {
+
+struct CentralEntry {
+    uint32_t source; // index into the entries
+    uint32_t crc;
+    uint32_t size;
+    uint32_t offset; // of the local header
+    uint16_t time;
+    uint16_t date;
+};
+
+// Little-endian fields appended to a small header buffer
+class FieldWriter {
+public:
+    void put16(uint32_t value) {
+        data.push_back(value);
+        data.push_back(value >> 8);
+    }
+
+    void put32(uint32_t value) {
+        put16(value);
+        put16(value >> 16);
+    }
+
+    void putText(const std::string &text) {
+        data.insert(data.end(), text.begin(), text.end());
+    }
+
+    std::vector<uint8_t> data;
+};
+
+class ZipOutput {
+public:
+    explicit ZipOutput(FILE *file) : file(file) {
+    }
+
+    bool write(const void *data, size_t size) {
+        if (offset + size > ZIP_MAX_OFFSET) {
+            return false;
+        }
+        offset += size;
+        return fwrite(data, 1, size, file) == size;
+    }
+
+    bool write(FieldWriter &fields) {
+        bool written = write(fields.data.data(), fields.data.size());
+        fields.data.clear();
+        return written;
+    }
+
+    // Overwrites bytes written earlier and carries on at the end
+    bool patch(uint64_t at, FieldWriter &fields) {
+        bool written = fseek(file, at, SEEK_SET) == 0 && fwrite(fields.data.data(), 1, fields.data.size(), file) == fields.data.size() &&
+                       fseek(file, offset, SEEK_SET) == 0;
+        fields.data.clear();
+        return written;
+    }
+
+    // Drops everything from `at` on; the file is trimmed by finish()
+    bool rewind(uint64_t at) {
+        offset = at;
+        rewound = true;
+        return fseek(file, at, SEEK_SET) == 0;
+    }
+
+    bool finish() {
+        return !rewound || (fflush(file) == 0 && ftruncate(fileno(file), offset) == 0);
+    }
+
+    uint64_t offset = 0;
+
+private:
+    FILE *file;
+    bool rewound = false;
+};
+
+} // namespace
+
+// DOS times count from 1980 in two-second steps; earlier or unknown times
+// become 1980-01-01
+static void getDosTime(uint64_t captureTime, uint16_t &time, uint16_t &date) {
+    uint64_t seconds = captureTime / 1000;
+    uint32_t second = seconds % 100;
+    uint32_t minute = seconds / 100 % 100;
+    uint32_t hour = seconds / 10000 % 100;
+    uint32_t day = seconds / 1000000 % 100;
+    uint32_t month = seconds / 100000000 % 100;
+    uint32_t year = seconds / 10000000000;
+    if (captureTime == CAPTURE_TIME_UNKNOWN || year < 1980 || year > 2107) {
+        time = 0;
+        date = 1 << 5 | 1;
+        return;
+    }
+    time = hour << 11 | minute << 5 | second / 2;
+    date = (year - 1980) << 9 | month << 5 | day;
+}
+
+static void putLocalHeader(FieldWriter &fields, const ZipEntrySource &source, const CentralEntry &entry) {
+    fields.put32(ZIP_LOCAL_HEADER_SIGNATURE);
+    fields.put16(ZIP_VERSION);
+    fields.put16(ZIP_FLAGS);
+    fields.put16(ZIP_METHOD_STORE);
+    fields.put16(entry.time);
+    fields.put16(entry.date);
+    // CRC and sizes are patched in once the data is written
+    fields.put32(0);
+    fields.put32(0);
+    fields.put32(0);
+    fields.put16(source.name.size());
+    fields.put16(0);
+    fields.putText(source.name);
+}
+
+static void putCentralHeader(FieldWriter &fields, const ZipEntrySource &source, const CentralEntry &entry) {
+    fields.put32(ZIP_CENTRAL_HEADER_SIGNATURE);
+    fields.put16(ZIP_VERSION);
+    fields.put16(ZIP_VERSION);
+    fields.put16(ZIP_FLAGS);
+    fields.put16(ZIP_METHOD_STORE);
+    fields.put16(entry.time);
+    fields.put16(entry.date);
+    fields.put32(entry.crc);
+    fields.put32(entry.size);
+    fields.put32(entry.size);
+    fields.put16(source.name.size());
+    fields.put16(0); // extra field
+    fields.put16(0); // comment
+    fields.put16(0); // disk
+    fields.put16(0); // internal attributes
+    fields.put32(0); // external attributes
+    fields.put32(entry.offset);
+    fields.putText(source.name);
+}
+
+static bool writeCentralDirectory(ZipOutput &output, const std::vector<ZipEntrySource> &entries, const std::vector<CentralEntry> &central) {
+    FieldWriter fields;
+    uint64_t start = output.offset;
+    for (const auto &entry : central) {
+        putCentralHeader(fields, entries[entry.source], entry);
+        if (!output.write(fields)) {
+            return false;
+        }
+    }
+    fields.put32(ZIP_END_SIGNATURE);
+    fields.put16(0); // this disk
+    fields.put16(0); // disk with the directory
+    fields.put16(central.size());
+    fields.put16(central.size());
+    fields.put32(output.offset - start);
+    fields.put32(start);
+    fields.put16(0); // comment
+    return output.write(fields);
+}
+
+bool writeZipArchive(const std::vector<ZipEntrySource> &entries, const std::string &zipPath, ExportProgress &progress) {
+    if (entries.size() > ZIP_MAX_ENTRIES) {
+        progress.filesFailed.store(entries.size(), std::memory_order_relaxed);
+        return false;
+    }
+    uint64_t total = 0;
+    std::vector<std::string> sources;
+    sources.reserve(entries.size());
+    for (const auto &entry : entries) {
+        struct stat st {};
+        if (stat(entry.path.c_str(), &st) == 0) {
+            total += st.st_size;
+        }
+        sources.push_back(entry.path);
+    }
+    progress.bytesTotal.store(total, std::memory_order_relaxed);
+
+    std::string partPath = zipPath + EXPORT_PART_SUFFIX;
+    BlockPipeline pipeline;
+    FILE *file = pipeline.allocate() ? fopen(partPath.c_str(), "wb") : nullptr;
+    if (file == nullptr) {
+        progress.filesFailed.store(entries.size(), std::memory_order_relaxed);
+        return false;
+    }
+    auto streamBuffer = std::make_unique<char[]>(ZIP_OUTPUT_BUFFER_SIZE);
+    setvbuf(file, streamBuffer.get(), _IOFBF, ZIP_OUTPUT_BUFFER_SIZE);
+    std::thread reader(readFilesIntoPipeline, std::cref(sources), std::ref(pipeline), std::cref(progress.cancelled));
+
+    ZipOutput output(file);
+    FieldWriter fields;
+    std::vector<CentralEntry> central;
+    central.reserve(entries.size());
+    CentralEntry current{};
+    bool open = false;
+    bool writeFailed = false;
+    while (PipelineBlock *block = pipeline.acquireFilled()) {
+        if (progress.cancelled.load(std::memory_order_relaxed) || writeFailed) {
+            pipeline.stop();
+            break;
+        }
+        // A file that cannot be read at all gets no entry
+        if (block->first && !block->failed) {
+            current = {block->file, 0, 0, static_cast<uint32_t>(output.offset), 0, 0};
+            getDosTime(entries[block->file].captureTime, current.time, current.date);
+            putLocalHeader(fields, entries[block->file], current);
+            writeFailed = !output.write(fields);
+            open = true;
+        }
+        if (open && !block->failed && block->size > 0) {
+            current.crc = updateCrc32(current.crc, block->data.get(), block->size);
+            current.size += block->size;
+            writeFailed = writeFailed || !output.write(block->data.get(), block->size);
+        }
+        progress.bytesCopied.fetch_add(block->size, std::memory_order_relaxed);
+
+        if (block->last) {
+            bool archived = open && !block->failed;
+            if (archived) {
+                fields.put32(current.crc);
+                fields.put32(current.size);
+                fields.put32(current.size);
+                writeFailed = writeFailed || !output.patch(current.offset + ZIP_LOCAL_CRC_OFFSET, fields);
+                central.push_back(current);
+            } else if (open) {
+                // A read error part way: the next entry goes where this one started
+                writeFailed = writeFailed || !output.rewind(current.offset);
+            }
+            (archived ? progress.filesCopied : progress.filesFailed).fetch_add(1, std::memory_order_relaxed);
+            open = false;
+        }
+        pipeline.release(block);
+    }
+    reader.join();
+
+    bool written = !writeFailed && !progress.cancelled.load(std::memory_order_relaxed) && writeCentralDirectory(output, entries, central) && output.finish();
+    written = fclose(file) == 0 && written;
+    if (written) {
+        // FAT cannot rename over an existing file
+        remove(zipPath.c_str());
+        written = rename(partPath.c_str(), zipPath.c_str()) == 0;
+    }
+    if (!written) {
+        remove(partPath.c_str());
+        progress.filesCopied.store(0, std::memory_order_relaxed);
+        progress.filesFailed.store(entries.size(), std::memory_order_relaxed);
+        return false;
+    }
+    return progress.filesCopied.load(std::memory_order_relaxed) == entries.size();
+}
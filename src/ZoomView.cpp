@@ -0,0 +1,345 @@
+#include <ImagePairScreen.h>
+#include <ZoomView.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Averages 2x2 blocks; an odd last row or column is averaged with itself.
+// `pitch` is in bytes.
+static void halveLevel(int width, int height, const uint8_t *source, size_t pitch, int &halfWidth, int &halfHeight, std::vector<uint32_t> &half) {
+    halfWidth = (width + 1) / 2;
+    halfHeight = (height + 1) / 2;
+    half.resize(static_cast<size_t>(halfWidth) * halfHeight);
+    for (int y = 0; y < halfHeight; y++) {
+        const uint8_t *top = source + static_cast<size_t>(2 * y) * pitch;
+        const uint8_t *bottom = source + static_cast<size_t>(std::min(2 * y + 1, height - 1)) * pitch;
+        uint8_t *out = reinterpret_cast<uint8_t *>(half.data() + static_cast<size_t>(y) * halfWidth);
+        for (int x = 0; x < halfWidth; x++) {
+            int left = 2 * x * 4;
+            int right = std::min(2 * x + 1, width - 1) * 4;
+            for (int channel = 0; channel < 4; channel++) {
+                out[x * 4 + channel] = (top[left + channel] + top[right + channel] + bottom[left + channel] + bottom[right + channel] + 2) / 4;
+            }
+        }
+    }
+}
+
+ZoomView::ZoomView(SDL_Renderer *renderer) : renderer(renderer) {
+}
+
+ZoomView::~ZoomView() {
+    clear();
+    // Leaving the view for good may wait for a build, nothing else does
+    for (auto &retiredBuild : retired) {
+        retiredBuild->thread.join();
+    }
+}
+
+bool ZoomView::needsLevels(int width, int height) {
+    return width >= 2 * SCREEN_WIDTH || height >= 2 * SCREEN_HEIGHT;
+}
+
+void ZoomView::setImage(SDL_Texture *fullTexture, std::shared_ptr<SDL_Surface> pixels) {
+    clear();
+    this->fullTexture = fullTexture;
+    this->pixels = std::move(pixels);
+    if (fullTexture == nullptr || SDL_QueryTexture(fullTexture, nullptr, nullptr, &imageWidth, &imageHeight) != 0 || imageWidth == 0 || imageHeight == 0) {
+        imageWidth = 0;
+        imageHeight = 0;
+        return;
+    }
+    fitScale = std::min(SCREEN_WIDTH / static_cast<float>(imageWidth), SCREEN_HEIGHT / static_cast<float>(imageHeight));
+    scale = fitScale;
+    centerX = imageWidth / 2.0f;
+    centerY = imageHeight / 2.0f;
+    // Console captures are never larger than the screen, so they are only
+    // ever drawn from the full texture
+    detailLevels = fitScale >= 1.0f ? 1 : static_cast<int>(std::floor(std::log2(1.0f / fitScale))) + 1;
+}
+
+void ZoomView::clear() {
+    if (build) {
+        // Decodes cannot be interrupted, the build is joined once it is done
+        build->cancelled.store(true, std::memory_order_relaxed);
+        retired.push_back(std::move(build));
+    }
+    reapBuilds();
+    for (auto &tile : tiles) {
+        SDL_DestroyTexture(tile.texture);
+    }
+    tiles.clear();
+    fullTexture = nullptr;
+    pixels.reset();
+    imageWidth = 0;
+    imageHeight = 0;
+    fitScale = 1.0f;
+    scale = 1.0f;
+    dragging = false;
+    // Stick motion is only seen while the view gets events, a release
+    // missed meanwhile would move the next image by itself
+    std::fill(std::begin(axes), std::end(axes), 0);
+}
+
+void ZoomView::reapBuilds() {
+    for (auto it = retired.begin(); it != retired.end();) {
+        if ((*it)->finished.load(std::memory_order_acquire)) {
+            (*it)->thread.join();
+            it = retired.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void ZoomView::startBuilding() {
+    if (!build && detailLevels > 1 && pixels) {
+        reapBuilds();
+        build = std::make_unique<Build>();
+        build->thread = std::thread(&ZoomView::buildPyramid, build.get(), pixels, detailLevels);
+    }
+}
+
+void ZoomView::buildPyramid(Build *build, std::shared_ptr<SDL_Surface> pixels, int detailLevels) {
+    std::vector<Level> &levels = build->levels;
+    // Level 0 is drawn from the full texture, its pixels stay in the surface
+    levels.push_back({pixels->w, pixels->h, {}});
+    const uint8_t *source = static_cast<const uint8_t *>(pixels->pixels);
+    size_t pitch = pixels->pitch;
+    // Down to a level that fits in one tile, which then covers everything
+    while ((levels.back().width > ZOOM_TILE_SIZE || levels.back().height > ZOOM_TILE_SIZE) && !build->cancelled.load(std::memory_order_relaxed)) {
+        Level half;
+        const Level &last = levels.back();
+        halveLevel(last.width, last.height, source, pitch, half.width, half.height, half.pixels);
+        if (static_cast<int>(levels.size()) > detailLevels) {
+            // Only needed to make the next one
+            levels.back().pixels = {};
+        }
+        levels.push_back(std::move(half));
+        source = reinterpret_cast<const uint8_t *>(levels.back().pixels.data());
+        pitch = static_cast<size_t>(levels.back().width) * 4;
+    }
+    build->built.store(!build->cancelled.load(std::memory_order_relaxed), std::memory_order_release);
+    build->finished.store(true, std::memory_order_release);
+}
+
+void ZoomView::handleEvent(const SDL_Event &event) {
+    if (imageWidth == 0) {
+        return;
+    }
+    switch (event.type) {
+        case SDL_CONTROLLERAXISMOTION:
+            if (event.caxis.axis < 4) {
+                axes[event.caxis.axis] = event.caxis.value;
+            }
+            break;
+        case SDL_FINGERDOWN:
+            dragging = isZoomed();
+            break;
+        case SDL_FINGERUP:
+            dragging = false;
+            break;
+        case SDL_FINGERMOTION:
+            if (dragging) {
+                centerX -= event.tfinger.dx * SCREEN_WIDTH / scale;
+                centerY -= event.tfinger.dy * SCREEN_HEIGHT / scale;
+                clampView();
+            }
+            break;
+        case SDL_MULTIGESTURE:
+            if (event.mgesture.numFingers >= 2) {
+                dragging = false;
+                zoomAt(1.0f + event.mgesture.dDist * ZOOM_PINCH_SPEED, event.mgesture.x * SCREEN_WIDTH, event.mgesture.y * SCREEN_HEIGHT);
+            }
+            break;
+    }
+}
+
+void ZoomView::update(float seconds) {
+    if (imageWidth == 0) {
+        return;
+    }
+    auto tilt = [](int16_t value) {
+        return std::abs(value) < ZOOM_STICK_DEADZONE ? 0.0f : value / 32767.0f;
+    };
+    float zoom = tilt(axes[SDL_CONTROLLER_AXIS_RIGHTY]);
+    if (zoom != 0.0f) {
+        // Up zooms in
+        zoomAt(std::exp2(-zoom * ZOOM_STICK_SPEED * seconds), SCREEN_WIDTH / 2.0f, SCREEN_HEIGHT / 2.0f);
+    }
+    float panX = tilt(axes[SDL_CONTROLLER_AXIS_LEFTX]);
+    float panY = tilt(axes[SDL_CONTROLLER_AXIS_LEFTY]);
+    if ((panX != 0.0f || panY != 0.0f) && isZoomed()) {
+        centerX += panX * ZOOM_PAN_SPEED * seconds / scale;
+        centerY += panY * ZOOM_PAN_SPEED * seconds / scale;
+        clampView();
+    }
+}
+
+void ZoomView::zoomAt(float factor, float screenX, float screenY) {
+    if (factor > 1.0f) {
+        startBuilding();
+    }
+    float imageX = centerX + (screenX - SCREEN_WIDTH / 2.0f) / scale;
+    float imageY = centerY + (screenY - SCREEN_HEIGHT / 2.0f) / scale;
+    scale = std::clamp(scale * factor, fitScale, std::max(fitScale, ZOOM_MAX_SCALE));
+    centerX = imageX - (screenX - SCREEN_WIDTH / 2.0f) / scale;
+    centerY = imageY - (screenY - SCREEN_HEIGHT / 2.0f) / scale;
+    clampView();
+}
+
+// An image larger than the screen keeps it covered, a smaller one stays centred
+void ZoomView::clampView() {
+    float halfWidth = SCREEN_WIDTH / 2.0f / scale;
+    float halfHeight = SCREEN_HEIGHT / 2.0f / scale;
+    centerX = imageWidth <= 2 * halfWidth ? imageWidth / 2.0f : std::clamp(centerX, halfWidth, imageWidth - halfWidth);
+    centerY = imageHeight <= 2 * halfHeight ? imageHeight / 2.0f : std::clamp(centerY, halfHeight, imageHeight - halfHeight);
+}
+
+// The finest level that is not drawn shrunk, so a level pixel covers at
+// least one screen pixel
+int ZoomView::getLevel() const {
+    int level = scale >= 1.0f ? 0 : static_cast<int>(std::floor(std::log2(1.0f / scale)));
+    return std::clamp(level, 0, std::min(detailLevels, static_cast<int>(build->levels.size())) - 1);
+}
+
+ZoomView::Tile *ZoomView::findTile(int level, int column, int row) {
+    for (auto &tile : tiles) {
+        if (tile.level == level && tile.column == column && tile.row == row) {
+            return &tile;
+        }
+    }
+    return nullptr;
+}
+
+ZoomView::Tile *ZoomView::uploadTile(int level, int column, int row) {
+    Tile *tile = nullptr;
+    if (tiles.size() < ZOOM_TILE_CACHE_SIZE) {
+        SDL_Texture *texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, ZOOM_TILE_SIZE, ZOOM_TILE_SIZE);
+        if (texture == nullptr) {
+            return nullptr;
+        }
+        tiles.push_back({level, column, row, texture, frame});
+        tile = &tiles.back();
+    } else {
+        // Tiles drawn this frame stay, the screen needs them
+        for (auto &candidate : tiles) {
+            if (candidate.lastUsed != frame && (tile == nullptr || candidate.lastUsed < tile->lastUsed)) {
+                tile = &candidate;
+            }
+        }
+        if (tile == nullptr) {
+            return nullptr;
+        }
+        *tile = {level, column, row, tile->texture, frame};
+    }
+    const Level &source = build->levels[level];
+    SDL_Rect area = {0, 0, std::min(ZOOM_TILE_SIZE, source.width - column * ZOOM_TILE_SIZE), std::min(ZOOM_TILE_SIZE, source.height - row * ZOOM_TILE_SIZE)};
+    const uint32_t *pixels = source.pixels.data() + static_cast<size_t>(row) * ZOOM_TILE_SIZE * source.width + column * ZOOM_TILE_SIZE;
+    SDL_UpdateTexture(tile->texture, &area, pixels, source.width * 4);
+    return tile;
+}
+
+void ZoomView::drawTile(const Tile &tile, const SDL_FRect &area) {
+    const Level &source = build->levels[tile.level];
+    float stepX = imageWidth / static_cast<float>(source.width);
+    float stepY = imageHeight / static_cast<float>(source.height);
+    // Level pixels of the tile that fall inside the area
+    int left = std::max(tile.column * ZOOM_TILE_SIZE, static_cast<int>(std::floor(area.x / stepX)));
+    int top = std::max(tile.row * ZOOM_TILE_SIZE, static_cast<int>(std::floor(area.y / stepY)));
+    int right = std::min({(tile.column + 1) * ZOOM_TILE_SIZE, source.width, static_cast<int>(std::ceil((area.x + area.w) / stepX))});
+    int bottom = std::min({(tile.row + 1) * ZOOM_TILE_SIZE, source.height, static_cast<int>(std::ceil((area.y + area.h) / stepY))});
+    if (right <= left || bottom <= top) {
+        return;
+    }
+    SDL_Rect sourceRect = {left - tile.column * ZOOM_TILE_SIZE, top - tile.row * ZOOM_TILE_SIZE, right - left, bottom - top};
+    SDL_FRect destination = {(left * stepX - centerX) * scale + SCREEN_WIDTH / 2.0f, (top * stepY - centerY) * scale + SCREEN_HEIGHT / 2.0f, (right - left) * stepX * scale,
+                             (bottom - top) * stepY * scale};
+    SDL_RenderCopyF(renderer, tile.texture, &sourceRect, &destination);
+}
+
+void ZoomView::drawFullTexture(const SDL_FRect &view) {
+    int left = std::max(0, static_cast<int>(std::floor(view.x)));
+    int top = std::max(0, static_cast<int>(std::floor(view.y)));
+    int right = std::min(imageWidth, static_cast<int>(std::ceil(view.x + view.w)));
+    int bottom = std::min(imageHeight, static_cast<int>(std::ceil(view.y + view.h)));
+    if (right <= left || bottom <= top) {
+        return;
+    }
+    SDL_Rect sourceRect = {left, top, right - left, bottom - top};
+    SDL_FRect destination = {(left - centerX) * scale + SCREEN_WIDTH / 2.0f, (top - centerY) * scale + SCREEN_HEIGHT / 2.0f, (right - left) * scale, (bottom - top) * scale};
+    SDL_RenderCopyF(renderer, fullTexture, &sourceRect, &destination);
+}
+
+void ZoomView::render() {
+    if (imageWidth == 0) {
+        return;
+    }
+    SDL_FRect view = {centerX - SCREEN_WIDTH / 2.0f / scale, centerY - SCREEN_HEIGHT / 2.0f / scale, SCREEN_WIDTH / scale, SCREEN_HEIGHT / scale};
+    // Full resolution, or a pyramid still being built, comes from the texture
+    if (!build || !build->built.load(std::memory_order_acquire) || getLevel() == 0) {
+        drawFullTexture(view);
+        return;
+    }
+    frame++;
+    const std::vector<Level> &levels = build->levels;
+
+    // The coarsest level is a single tile under everything else
+    int coarsest = levels.size() - 1;
+    Tile *base = findTile(coarsest, 0, 0);
+    if (base == nullptr) {
+        base = uploadTile(coarsest, 0, 0);
+    }
+    if (base) {
+        base->lastUsed = frame;
+        drawTile(*base, view);
+    }
+
+    int level = getLevel();
+    if (level == coarsest) {
+        return;
+    }
+    const Level &source = levels[level];
+    float tileWidth = ZOOM_TILE_SIZE * imageWidth / static_cast<float>(source.width);
+    float tileHeight = ZOOM_TILE_SIZE * imageHeight / static_cast<float>(source.height);
+    int firstColumn = std::max(0, static_cast<int>(view.x / tileWidth));
+    int firstRow = std::max(0, static_cast<int>(view.y / tileHeight));
+    int lastColumn = std::min((source.width - 1) / ZOOM_TILE_SIZE, static_cast<int>((view.x + view.w) / tileWidth));
+    int lastRow = std::min((source.height - 1) / ZOOM_TILE_SIZE, static_cast<int>((view.y + view.h) / tileHeight));
+
+    struct MissingTile {
+        int column;
+        int row;
+        float distance; // from the middle of the screen, in tiles
+    };
+    std::vector<MissingTile> missing;
+    for (int row = firstRow; row <= lastRow; row++) {
+        for (int column = firstColumn; column <= lastColumn; column++) {
+            SDL_FRect area = {column * tileWidth, row * tileHeight, tileWidth, tileHeight};
+            if (Tile *tile = findTile(level, column, row)) {
+                tile->lastUsed = frame;
+                drawTile(*tile, area);
+                continue;
+            }
+            // The nearest coarser tile fills in until this one is uploaded,
+            // the coarsest level is already drawn underneath
+            for (int up = level + 1; up < std::min(detailLevels, coarsest); up++) {
+                if (Tile *parent = findTile(up, column >> (up - level), row >> (up - level))) {
+                    parent->lastUsed = frame;
+                    drawTile(*parent, area);
+                    break;
+                }
+            }
+            float dx = (column + 0.5f) * tileWidth - centerX;
+            float dy = (row + 0.5f) * tileHeight - centerY;
+            missing.push_back({column, row, (dx * dx + dy * dy) / (tileWidth * tileHeight)});
+        }
+    }
+    std::sort(missing.begin(), missing.end(), [](const MissingTile &a, const MissingTile &b) {
+        return a.distance < b.distance;
+    });
+    for (size_t i = 0; i < missing.size() && i < ZOOM_UPLOADS_PER_FRAME; i++) {
+        if (Tile *tile = uploadTile(level, missing[i].column, missing[i].row)) {
+            drawTile(*tile, {missing[i].column * tileWidth, missing[i].row * tileHeight, tileWidth, tileHeight});
+        }
+    }
+}
@@ -1,26 +1,52 @@
+#include <AssetPack.h>
 #include <Button.h>
+#include <CaptureTime.h>
+#include <ContactSheet.h>
+#include <DuplicateFinder.h>
+#include <FileExporter.h>
+#include <FolderIndex.h>
+#include <HashCache.h>
+#include <ImageLibrary.h>
 #include <ImagePairScreen.h>
-#include <MutexWrapper.h>
+#include <MetadataProber.h>
+#include <MusicStream.h>
+#include <PerceptualHash.h>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_mixer.h>
 #include <SDL_FontCache.h>
+#include <ScanProgress.h>
+#include <ScreenshotScanner.h>
+#include <ScrollEngine.h>
+#include <SelectionModel.h>
+#include <Slideshow.h>
+#include <SortOrder.h>
+#include <StorageOptimizer.h>
+#include <TexturePool.h>
+#include <TextureUploadQueue.h>
+#include <ThumbnailScheduler.h>
+#include <TrashBin.h>
+#include <ZipWriter.h>
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cmath>
 #include <coreinit/filesystem.h>
 #include <coreinit/memdefaultheap.h>
 #include <coreinit/memory.h>
 #include <coreinit/thread.h>
+#include <cstdarg>
+#include <ctime>
 #include <filesystem>
+#include <functional>
 #include <future>
 #include <iostream>
+#include <memory>
 #include <nn/erreula.h>
 #include <romfs-wiiu.h>
 #include <sndcore2/core.h>
 #include <string>
-#include <sys/stat.h>
 #include <thread>
-#include <unordered_map>
 #include <vector>
 #include <vpad/input.h>
 
@@ -28,6 +54,12 @@
 #define IMAGE_WIDTH          SCREEN_WIDTH / GRID_SIZE / 2
 #define IMAGE_HEIGHT         SCREEN_HEIGHT / GRID_SIZE / 2
 #define SEPARATION           IMAGE_WIDTH / 4
+#define ROW_PITCH            (IMAGE_WIDTH + SEPARATION)
+#define TILE_HEIGHT          (IMAGE_HEIGHT + IMAGE_HEIGHT / 2)
+#define TAP_SLOP             20
+#define RANGE_SELECT_HOLD_MS 400
+#define TRASH_IDLE_MS        1500 // no input for this long lets the trash purge run
+#define THUMBNAIL_POOL_SIZE  (2 * GRID_SIZE * 20) // TV + DRC for 20 rows, more than the keep window
 #define FONT_SIZE            36
 #define TRAIL_LENGTH         20
 #define SCREEN_COLOR_BLACK   ((SDL_Color){.r = 0x00, .g = 0x00, .b = 0x00, .a = 0xFF})
@@ -38,6 +70,11 @@
 #define BUTTON_A             "\uE000"
 #define BUTTON_B             "\uE001"
 #define BUTTON_X             "\uE002"
+#define BUTTON_Y             "\uE003"
+#define BUTTON_L             "\uE004"
+#define BUTTON_R             "\uE005"
+#define BUTTON_PLUS          "\uE045"
+#define BUTTON_MINUS         "\uE046"
 #define BUTTON_DPAD          "\uE07D"
 #define THREAD_PRIORITY_HIGH 13
 #ifdef EMU
@@ -45,13 +82,25 @@
 #else
 #define SCREENSHOT_PATH "fs:/vol/external01/wiiu/screenshots/"
 #endif
+// wut only mounts the SD card, so exports stay next to the screenshots
+#define EXPORT_PATH       "fs:/vol/external01/wiiu/screenshots_export"
+#define STATUS_MESSAGE_MS 4000
 
 enum class MenuState {
+    ShowFolders,
     ShowAllImages,
     SelectImagesDelete,
     ShowSingleImage,
 };
 
+enum class SelectionAction {
+    Cancelled,
+    CopyFiles,
+    Archive,
+    ContactSheet,
+    Optimize,
+};
+
 struct Texture {
     SDL_Texture *texture;
     SDL_Rect rect;
@@ -64,6 +113,15 @@ struct Particle {
     SDL_Rect rect;
 };
 
+// What is needed to put a deleted pair back into the grid after an undo
+struct TrashedPair {
+    uint32_t folder;
+    std::string stem;
+    ImageFormat tvFormat;
+    ImageFormat drcFormat;
+    uint64_t captureTime;
+};
+
 const std::string imagePath = SCREENSHOT_PATH;
 FC_Font *font = nullptr;
 SDL_Texture *orbTexture = nullptr;
@@ -74,19 +132,40 @@ SDL_Texture *largeCornerButtonTexture = nullptr;
 SDL_Texture *arrowTexture = nullptr;
 SDL_Texture *blackTexture = nullptr;
 SDL_Texture *placeholderTexture = nullptr;
+std::unique_ptr<TexturePool> thumbnailPool;
 Texture headerTexture;
 Texture backgroundTexture;
 Texture backGraphicTexture;
 Texture pointerTexture;
 
-static uint8_t *bgmBuffer = nullptr;
 static Mix_Music *backgroundMusic = nullptr;
+static bool audioOpened = false;
 
 std::vector<Particle> particles;
 std::vector<SDL_Point> pointerTrail;
-
-bool fileEndsWith(const std::string &filename, const std::string &extension) {
-    return filename.size() >= extension.size() && std::equal(extension.rbegin(), extension.rend(), filename.rbegin());
+std::vector<ThumbnailResult> thumbnailResults;
+std::vector<ProbeResult> probeResults;
+std::vector<ThumbnailRequest> thumbnailRequests;
+std::vector<uint32_t> residentThumbnails;
+SelectionModel selection;
+ImageLibrary library;
+std::vector<SlotHandle> displayOrder; // grid order, all the layout reads
+std::vector<TrashedPair> lastTrashedPairs;
+std::vector<uint32_t> folderOrder; // folder index of every tile while the folder grid is shown
+SortMode sortMode = SortMode::NewestFirst;
+ThumbnailViewport lastThumbnailViewport;
+bool thumbnailWindowDirty = true;
+bool hashCacheDirty = false; // the opened folder has hashes or header capture times its cache file lacks
+char statusMessage[160] = "";
+Uint32 statusMessageTicks = 0;
+
+// Shown above the button hints for a few seconds, for results of batch actions
+void setStatusMessage(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    vsnprintf(statusMessage, sizeof(statusMessage), format, args);
+    va_end(args);
+    statusMessageTicks = SDL_GetTicks();
 }
 
 bool isPointInsideRect(int x, int y, const SDL_Rect &rect) {
@@ -97,15 +176,6 @@ bool isPointInsideRect(int x, int y, int w, int h, int rectX, int rectY) {
     return (x >= rectX && x <= rectX + w && y >= rectY && y <= rectY + h);
 }
 
-bool isFirstRow(int index) {
-    return index < GRID_SIZE;
-}
-
-bool isLastRow(int index, int imageCount) {
-    int lastRow = (imageCount - 1) / GRID_SIZE;
-    return index >= (lastRow * GRID_SIZE);
-}
-
 Particle generateParticle(float x, float y) {
     Particle particle;
     particle.x = x;
@@ -137,6 +207,7 @@ void renderBackgroundParticles(SDL_Renderer *renderer, std::vector<Particle> &pa
             ++it;
         }
     }
+    SDL_SetTextureColorMod(particleTexture, 255, 255, 255);
     for (const Particle &particle : particles) {
         SDL_RenderCopy(renderer, particleTexture, nullptr, &particle.rect);
     }
@@ -163,8 +234,17 @@ void renderGhostPointers(SDL_Renderer *renderer, const std::vector<SDL_Point> &t
     }
 }
 
-bool isImageVisible(const ImagesPair &image, int scrollOffsetY, bool fullyVisible) {
-    int imageTop = headerTexture.rect.h + image.y + scrollOffsetY;
+int getRowTop(int row, int offsetY) {
+    return headerTexture.rect.h + offsetY + row * ROW_PITCH;
+}
+
+// Screen position of a tile, derived from its place in the display order
+SDL_Point getImagePosition(int displayIndex, int offsetX, int offsetY, int scrollOffsetY) {
+    return {offsetX + displayIndex % GRID_SIZE * ROW_PITCH, getRowTop(displayIndex / GRID_SIZE, offsetY) + scrollOffsetY};
+}
+
+bool isImageVisible(int displayIndex, int offsetY, int scrollOffsetY, bool fullyVisible) {
+    int imageTop = getRowTop(displayIndex / GRID_SIZE, offsetY) + scrollOffsetY;
     int imageBottom = imageTop + IMAGE_HEIGHT + IMAGE_HEIGHT / 2;
 
     int screenTop = headerTexture.rect.h / 2;
@@ -176,12 +256,324 @@ bool isImageVisible(const ImagesPair &image, int scrollOffsetY, bool fullyVisibl
     return (imageBottom >= screenTop) && (imageTop <= screenBottom);
 }
 
-SDL_Texture *loadTexture(SDL_Renderer *renderer, const std::string path) {
-    SDL_Texture *texture = IMG_LoadTexture(renderer, path.c_str());
-    if (texture) {
-        return texture;
+// First tile of the first row isImageVisible accepts, so drawing only walks
+// the visible rows
+int getFirstDrawnImage(int offsetY, int scrollOffsetY) {
+    int hidden = headerTexture.rect.h / 2 - getRowTop(0, offsetY) - scrollOffsetY - TILE_HEIGHT;
+    return hidden > 0 ? (hidden + ROW_PITCH - 1) / ROW_PITCH * GRID_SIZE : 0;
+}
+
+void updateScrollBounds(ScrollEngine &scrollEngine, int imageCount, int offsetY) {
+    int rows = (imageCount + GRID_SIZE - 1) / GRID_SIZE;
+    int contentBottom = rows > 0 ? getRowTop(rows - 1, offsetY) + TILE_HEIGHT + SEPARATION : 0;
+    scrollEngine.setBounds(std::min(0, SCREEN_HEIGHT - contentBottom), 0.0f);
+}
+
+void scrollToImage(ScrollEngine &scrollEngine, int index, int offsetY) {
+    int rowTop = getRowTop(index / GRID_SIZE, offsetY);
+    scrollEngine.ensureVisible(rowTop - SEPARATION / 2, rowTop + TILE_HEIGHT + SEPARATION / 2, headerTexture.rect.h, SCREEN_HEIGHT);
+}
+
+// After a whole batch got selected, so the user lands on the first of it
+void scrollToFirstSelected(ScrollEngine &scrollEngine, int &selectedImageIndex, int offsetY) {
+    for (int i = 0; i < static_cast<int>(displayOrder.size()); i++) {
+        if (selection.isSelected(i)) {
+            selectedImageIndex = i;
+            scrollToImage(scrollEngine, selectedImageIndex, offsetY);
+            return;
+        }
+    }
+}
+
+// Index of the tile under a screen point, or -1
+int findImageAt(int x, int y, int offsetX, int offsetY, int scrollOffsetY) {
+    int left = x - offsetX;
+    int top = y - getRowTop(0, offsetY) - scrollOffsetY;
+    if (left < 0 || top < 0 || left / ROW_PITCH >= GRID_SIZE) {
+        return -1;
+    }
+    int index = top / ROW_PITCH * GRID_SIZE + left / ROW_PITCH;
+    if (index >= static_cast<int>(displayOrder.size())) {
+        return -1;
+    }
+    SDL_Point position = getImagePosition(index, offsetX, offsetY, scrollOffsetY);
+    return isPointInsideRect(x, y, IMAGE_WIDTH, IMAGE_HEIGHT, position.x, position.y) ? index : -1;
+}
+
+void getFolderRange(int index, int &first, int &last) {
+    uint32_t folder = library.getFolder(displayOrder[index]);
+    first = index;
+    last = index;
+    while (first > 0 && library.getFolder(displayOrder[first - 1]) == folder) {
+        first--;
+    }
+    while (last + 1 < static_cast<int>(displayOrder.size()) && library.getFolder(displayOrder[last + 1]) == folder) {
+        last++;
+    }
+}
+
+// Index of the tile in the same column on the first fully visible row
+int findFirstVisibleImage(int selectedImageIndex, int imageCount, int offsetY, int scrollOffsetY) {
+    int lastRow = (imageCount - 1) / GRID_SIZE;
+    int row = std::clamp((-offsetY - scrollOffsetY + ROW_PITCH - 1) / ROW_PITCH, 0, lastRow);
+    return std::min(row * GRID_SIZE + selectedImageIndex % GRID_SIZE, imageCount - 1);
+}
+
+SDL_Texture *getThumbnailTexture(uint16_t slot) {
+    if (slot == THUMBNAIL_SLOT_NONE) {
+        return placeholderTexture;
+    }
+    if (slot == THUMBNAIL_SLOT_FAILED) {
+        return blackTexture;
+    }
+    return thumbnailPool->getTexture(slot);
+}
+
+bool isThumbnailLoaded(SlotHandle handle) {
+    return library.getThumbnailTV(handle) != THUMBNAIL_SLOT_NONE;
+}
+
+void releaseThumbnail(SlotHandle handle) {
+    if (library.getThumbnailTV(handle) < THUMBNAIL_SLOT_FAILED) {
+        thumbnailPool->release(library.getThumbnailTV(handle));
+    }
+    if (library.getThumbnailDRC(handle) < THUMBNAIL_SLOT_FAILED) {
+        thumbnailPool->release(library.getThumbnailDRC(handle));
+    }
+    library.setThumbnails(handle, THUMBNAIL_SLOT_NONE, THUMBNAIL_SLOT_NONE);
+}
+
+uint16_t createThumbnailSlot(SDL_Surface *surface) {
+    if (!surface) {
+        return THUMBNAIL_SLOT_FAILED;
+    }
+    int slot = thumbnailPool->acquire();
+    if (slot >= 0 && !thumbnailPool->upload(slot, surface)) {
+        thumbnailPool->release(slot);
+        slot = -1;
+    }
+    SDL_FreeSurface(surface);
+    return slot >= 0 ? slot : THUMBNAIL_SLOT_FAILED;
+}
+
+// Makes room in the pool by dropping the resident thumbnail least likely to
+// be looked at
+bool evictFarthestThumbnail(const ThumbnailViewport &viewport) {
+    if (residentThumbnails.empty()) {
+        return false;
+    }
+    auto farthest = std::max_element(residentThumbnails.begin(), residentThumbnails.end(), [&](uint32_t a, uint32_t b) {
+        return getThumbnailPriority(a / GRID_SIZE, viewport) < getThumbnailPriority(b / GRID_SIZE, viewport);
+    });
+    releaseThumbnail(displayOrder[*farthest]);
+    residentThumbnails.erase(farthest);
+    return true;
+}
+
+// Uploads finished thumbnails within the frame budget, evicts the ones far
+// from the viewport and hands the scheduler the tiles worth decoding next
+void updateThumbnails(ThumbnailScheduler &scheduler, TextureUploadQueue &uploadQueue, const ScrollEngine &scrollEngine, int offsetY) {
+    thumbnailResults.clear();
+    scheduler.collect(thumbnailResults);
+    for (const auto &result : thumbnailResults) {
+        if (result.hashed && !(library.getFlags(displayOrder[result.index]) & IMAGE_FLAG_HASHED)) {
+            library.setPerceptualHash(displayOrder[result.index], result.hash);
+            hashCacheDirty = true;
+        }
+        uploadQueue.push(result);
+    }
+
+    int rowCount = (static_cast<int>(displayOrder.size()) + GRID_SIZE - 1) / GRID_SIZE;
+    if (rowCount == 0) {
+        uploadQueue.clear();
+        return;
+    }
+    float rowZeroTop = getRowTop(0, offsetY) + scrollEngine.getOffset();
+    float predictedRowZeroTop = getRowTop(0, offsetY) + scrollEngine.getPredictedOffset(THUMBNAIL_PREDICT_SECONDS);
+    ThumbnailViewport viewport = computeThumbnailViewport(rowZeroTop, predictedRowZeroTop, ROW_PITCH, TILE_HEIGHT, headerTexture.rect.h / 2, SCREEN_HEIGHT,
+                                                          rowCount, scrollEngine.getPredictedVelocity(0.0f));
+    int keepFirst = (viewport.firstPrefetchRow - THUMBNAIL_EVICT_MARGIN) * GRID_SIZE;
+    int keepLast = (viewport.lastPrefetchRow + THUMBNAIL_EVICT_MARGIN + 1) * GRID_SIZE - 1;
+
+    uploadQueue.process(
+            [&](uint32_t index) {
+                if (index >= displayOrder.size() || isThumbnailLoaded(displayOrder[index]) || static_cast<int>(index) < keepFirst || static_cast<int>(index) > keepLast) {
+                    return -1.0f;
+                }
+                return getThumbnailPriority(index / GRID_SIZE, viewport);
+            },
+            [&](const ThumbnailResult &result) {
+                while (thumbnailPool->getAvailable() < 2 && evictFarthestThumbnail(viewport)) {
+                }
+                uint16_t tv = createThumbnailSlot(result.surfaceTV);
+                library.setThumbnails(displayOrder[result.index], tv, createThumbnailSlot(result.surfaceDRC));
+                residentThumbnails.push_back(result.index);
+            });
+
+    auto evicted = std::remove_if(residentThumbnails.begin(), residentThumbnails.end(), [&](uint32_t index) {
+        if (static_cast<int>(index) >= keepFirst && static_cast<int>(index) <= keepLast) {
+            return false;
+        }
+        releaseThumbnail(displayOrder[index]);
+        return true;
+    });
+    residentThumbnails.erase(evicted, residentThumbnails.end());
+
+    if (!thumbnailWindowDirty && viewport.firstPrefetchRow == lastThumbnailViewport.firstPrefetchRow && viewport.lastPrefetchRow == lastThumbnailViewport.lastPrefetchRow &&
+        viewport.firstVisibleRow == lastThumbnailViewport.firstVisibleRow && viewport.direction == lastThumbnailViewport.direction) {
+        return;
+    }
+    lastThumbnailViewport = viewport;
+    thumbnailWindowDirty = false;
+
+    thumbnailRequests.clear();
+    for (int row = viewport.firstPrefetchRow; row <= viewport.lastPrefetchRow; row++) {
+        float priority = getThumbnailPriority(row, viewport);
+        for (int index = row * GRID_SIZE; index < std::min((row + 1) * GRID_SIZE, static_cast<int>(displayOrder.size())); index++) {
+            if (!isThumbnailLoaded(displayOrder[index]) && !uploadQueue.isPending(index)) {
+                thumbnailRequests.push_back({static_cast<uint32_t>(index), priority});
+            }
+        }
+    }
+    scheduler.schedule(thumbnailRequests, [&](uint32_t index, std::string &pathTV, std::string &pathDRC) {
+        library.buildPath(displayOrder[index], ScreenshotKind::TV, pathTV);
+        library.buildPath(displayOrder[index], ScreenshotKind::DRC, pathDRC);
+    });
+}
+
+// Indices shift after deletes, so everything in flight is stale
+void resetThumbnails(ThumbnailScheduler &scheduler, TextureUploadQueue &uploadQueue) {
+    scheduler.reset();
+    uploadQueue.clear();
+    residentThumbnails.clear();
+    for (size_t i = 0; i < displayOrder.size(); i++) {
+        if (isThumbnailLoaded(displayOrder[i])) {
+            residentThumbnails.push_back(i);
+        }
+    }
+    thumbnailWindowDirty = true;
+}
+
+// Drops everything the grid shows, before it is filled with another folder
+void clearGrid(ThumbnailScheduler &scheduler, TextureUploadQueue &uploadQueue, MetadataProber &prober) {
+    scheduler.reset();
+    uploadQueue.clear();
+    prober.reset();
+    for (SlotHandle handle : displayOrder) {
+        releaseThumbnail(handle);
+    }
+    residentThumbnails.clear();
+    library.clear();
+    displayOrder.clear();
+    selection.resize(0);
+    thumbnailWindowDirty = true;
+}
+
+// Queues header probes in grid order, so the tiles in view get their real
+// aspect ratio first
+void probeMetadata(MetadataProber &prober, const std::vector<SlotHandle> &handles) {
+    std::vector<ProbeJob> jobs;
+    jobs.reserve(handles.size());
+    for (SlotHandle handle : handles) {
+        ProbeJob job{handle, {}, {}};
+        library.buildPath(handle, ScreenshotKind::TV, job.pathTV);
+        library.buildPath(handle, ScreenshotKind::DRC, job.pathDRC);
+        jobs.push_back(std::move(job));
+    }
+    prober.submit(std::move(jobs));
+}
+
+// Converted pairs have new paths: thumbnails and probes queued for the old
+// ones are dropped and their headers are read again
+void reloadOptimizedPairs(ThumbnailScheduler &scheduler, TextureUploadQueue &uploadQueue, MetadataProber &prober) {
+    resetThumbnails(scheduler, uploadQueue);
+    prober.reset();
+    // Only converted pairs lost their metadata to setFormat, along with the
+    // ones the first pass had not reached yet
+    std::vector<SlotHandle> unprobed;
+    for (SlotHandle handle : displayOrder) {
+        if (!(library.getFlags(handle) & IMAGE_FLAG_PROBED)) {
+            unprobed.push_back(handle);
+        }
+    }
+    probeMetadata(prober, unprobed);
+}
+
+void collectMetadata(MetadataProber &prober) {
+    probeResults.clear();
+    prober.collect(probeResults);
+    for (const auto &result : probeResults) {
+        // Pairs deleted while they were queued are skipped
+        if (library.contains(result.handle)) {
+            library.setInfo(result.handle, result.tv, result.drc);
+        }
+    }
+}
+
+// The folder grid is a library of one cover per folder, so it scrolls and
+// streams thumbnails exactly like the grid of an opened folder. Only one
+// half of each cover is decoded.
+void loadFolderCovers(const FolderIndex &folderIndex) {
+    library.reserve(folderIndex.size());
+    displayOrder.reserve(folderIndex.size());
+    folderOrder.clear();
+    for (size_t i = 0; i < folderIndex.size(); i++) {
+        const FolderEntry &entry = folderIndex.get(i);
+        // Emptied by deletes since the last refresh, which moves it out of the index
+        if (entry.pairCount == 0) {
+            continue;
+        }
+        uint32_t folder = library.addFolder(folderIndex.getPath(i));
+        bool useTV = entry.coverTVFormat != ImageFormat::Unknown;
+        displayOrder.push_back(library.add(folder, entry.coverStem, useTV ? entry.coverTVFormat : ImageFormat::Unknown, useTV ? ImageFormat::Unknown : entry.coverDRCFormat));
+        folderOrder.push_back(i);
+    }
+    selection.resize(displayOrder.size());
+}
+
+// Folders are indexed by name, so by game is index order and the
+// chronological modes go by each folder's newest capture
+void sortFolders(const FolderIndex &folderIndex, SortMode mode) {
+    std::vector<SortKey> keys(folderOrder.size());
+    for (size_t i = 0; i < folderOrder.size(); i++) {
+        uint32_t folder = folderOrder[i];
+        uint64_t key = mode == SortMode::ByGame ? folder : makeCaptureSortKey(folderIndex.get(folder).newestCapture, mode);
+        keys[i] = {key, folder, static_cast<uint32_t>(i)};
+    }
+    sortByKeys(keys);
+    applySortOrder(folderOrder, keys);
+    applySortOrder(displayOrder, keys);
+}
+
+// Every pair in a folder belongs to the same game, so by game falls back to
+// newest first there. Ties go by slot, which is scan order after a fresh scan.
+void sortImages(SortMode mode) {
+    SortMode captureMode = mode == SortMode::ByGame ? SortMode::NewestFirst : mode;
+    std::vector<SortKey> keys(displayOrder.size());
+    for (size_t i = 0; i < displayOrder.size(); i++) {
+        SlotHandle handle = displayOrder[i];
+        keys[i] = {makeCaptureSortKey(library.getCaptureTime(handle), captureMode), handle.index, static_cast<uint32_t>(i)};
     }
-    return blackTexture;
+    sortByKeys(keys);
+    applySortOrder(displayOrder, keys);
+}
+
+// Keeps the index in step with the opened folder after a scan, delete or undo
+void updateFolderEntry(FolderIndex &folderIndex, int folder) {
+    if (displayOrder.empty()) {
+        folderIndex.update(folder, 0, CAPTURE_TIME_UNKNOWN, {}, ImageFormat::Unknown, ImageFormat::Unknown);
+        return;
+    }
+    // Newest capture, and the later stem on equal times, like FolderIndex picks it
+    SlotHandle cover = displayOrder[0];
+    for (SlotHandle handle : displayOrder) {
+        uint64_t captureTime = library.getCaptureTime(handle);
+        if (captureTime > library.getCaptureTime(cover) || (captureTime == library.getCaptureTime(cover) && library.getStem(handle) > library.getStem(cover))) {
+            cover = handle;
+        }
+    }
+    folderIndex.update(folder, displayOrder.size(), library.getCaptureTime(cover), library.getStem(cover), library.getFormat(cover, ScreenshotKind::TV),
+                       library.getFormat(cover, ScreenshotKind::DRC));
 }
 
 void drawRectFilled(SDL_Renderer *renderer, int x, int y, int w, int h, SDL_Color color) {
@@ -290,112 +682,601 @@ bool showConfirmationDialog(SDL_Renderer *renderer, bool *quit) {
     return selectedOk;
 }
 
-std::vector<ImagesPair> scanImagePairsInSubfolders(SDL_Renderer *renderer, const std::string &directoryPath, int offsetX, int offsetY, int *totalImages, MutexWrapper totalImagesMutex) {
-    std::vector<ImagesPair> imagePairs;
-    int pairIndex = 1;
+// Fills a library and its grid order from one folder. Thumbnails are decoded
+// later, only for the part of the grid in view. `cacheStale` is set when
+// capture times had to be read from headers the folder's cache lacks.
+void scanImagePairsInFolder(const std::string &directoryPath, ImageLibrary &scannedLibrary, std::vector<SlotHandle> &scannedOrder, bool &cacheStale, ScanProgress *progress) {
+    ScreenshotScanner scanner(progress);
+    scanner.scan(directoryPath, DirectoryBackend::Posix, false);
+    scannedLibrary.reserve(scanner.getPairs().size());
+    scannedOrder.reserve(scanner.getPairs().size());
+
+    // Pairs come grouped by directory, so each folder is added once
+    uint32_t scannedDirectory = UINT32_MAX;
+    uint32_t folder = 0;
+    ImageProbe probe;
+    for (const auto &pair : scanner.getPairs()) {
+        if (pair.directory != scannedDirectory) {
+            scannedDirectory = pair.directory;
+            folder = scannedLibrary.addFolder(scanner.getDirectory(pair.directory));
+        }
+        SlotHandle handle = scannedLibrary.add(folder, pair.stem, pair.tvFormat, pair.drcFormat);
+        uint64_t captureTime = parseCaptureTime(pair.stem);
+        if (captureTime != CAPTURE_TIME_UNKNOWN) {
+            scannedLibrary.setCaptureTime(handle, captureTime);
+        }
+        scannedOrder.push_back(handle);
+    }
+    loadHashCache(directoryPath, scannedLibrary, scannedOrder);
+    // Only names without a timestamp that the cache does not know yet are probed
+    cacheStale = false;
+    const auto &pairs = scanner.getPairs();
+    for (size_t i = 0; i < pairs.size(); i++) {
+        if (!(scannedLibrary.getFlags(scannedOrder[i]) & IMAGE_FLAG_TIMED)) {
+            scannedLibrary.setCaptureTime(scannedOrder[i], getPairCaptureTime(scanner, pairs[i], probe));
+            cacheStale = true;
+        }
+    }
+}
 
-    if (!std::filesystem::exists(directoryPath) || !std::filesystem::is_directory(directoryPath)) {
-        return imagePairs;
+SDL_GameController *findController() {
+    for (int i = 0; i < SDL_NumJoysticks(); i++) {
+        if (SDL_IsGameController(i)) {
+            return SDL_GameControllerOpen(i);
+        }
     }
 
-    std::unordered_map<std::string, std::pair<std::string, std::string>> baseFilenames;
+    return nullptr;
+}
 
-    for (const auto &entry : std::filesystem::recursive_directory_iterator(directoryPath)) {
-        if (!entry.is_regular_file()) {
-            continue;
-        }
+void renderHeader(SDL_Renderer *renderer, FC_Font *font, const Texture &headerTexture, const std::string &title) {
+    SDL_SetTextureColorMod(headerTexture.texture, 0, 0, 147);
+    SDL_SetTextureBlendMode(headerTexture.texture, SDL_BLENDMODE_BLEND);
+    SDL_RenderCopy(renderer, headerTexture.texture, nullptr, &headerTexture.rect);
+    FC_DrawColor(font, renderer, headerTexture.rect.x + (headerTexture.rect.w / 2), (headerTexture.rect.y + (headerTexture.rect.h / 2)) - 100, SCREEN_COLOR_WHITE, "%s", title.c_str());
+}
 
-        std::string filename = entry.path().filename().string();
-        std::string baseFilename = filename.substr(0, filename.find_last_of('_'));
-        if (fileEndsWith(filename, "_TV.jpg") || fileEndsWith(filename, "_TV.png") || fileEndsWith(filename, "_TV.bmp")) {
-            baseFilenames[baseFilename].first = entry.path().string();
-        } else if (fileEndsWith(filename, "_DRC.jpg") || fileEndsWith(filename, "_DRC.png") || fileEndsWith(filename, "_DRC.bmp")) {
-            baseFilenames[baseFilename].second = entry.path().string();
-        }
+void renderImage(SDL_Renderer *renderer, SDL_Texture *textureTV, SDL_Texture *textureDRC, const ImageInfo *infoTV, const ImageInfo *infoDRC, SDL_Point position, bool selected,
+                 MenuState state) {
+    SDL_Rect destRectTV = {position.x, position.y, IMAGE_WIDTH, IMAGE_HEIGHT};
+    SDL_Rect destRectDRC = {position.x + IMAGE_WIDTH / 2, position.y + IMAGE_WIDTH / 2, IMAGE_WIDTH / 2, IMAGE_HEIGHT / 2};
+    if (selected) {
+        SDL_SetTextureColorMod(textureTV, 0, 255, 0);
+        SDL_SetTextureColorMod(textureDRC, 0, 255, 0);
+    } else {
+        SDL_SetTextureColorMod(textureTV, 255, 255, 255);
+        SDL_SetTextureColorMod(textureDRC, 255, 255, 255);
+    }
+    SDL_SetTextureBlendMode(textureTV, SDL_BLENDMODE_BLEND);
+    SDL_SetTextureBlendMode(textureDRC, SDL_BLENDMODE_BLEND);
+    renderFittedImage(renderer, textureTV, infoTV, destRectTV);
+    renderFittedImage(renderer, textureDRC, infoDRC, destRectDRC);
+    if (state == MenuState::SelectImagesDelete) {
+        drawOrb(renderer, position.x - 10, position.y - 10, 60, selected);
     }
+}
 
-    for (const auto &[baseFilename, paths] : baseFilenames) {
-        std::string tvPath = paths.first;
-        std::string drcPath = paths.second;
+void renderFolder(SDL_Renderer *renderer, SDL_Texture *cover, const ImageInfo *coverInfo, SDL_Point position, std::string_view name, uint32_t pairCount) {
+    SDL_Rect destRect = {position.x, position.y, IMAGE_WIDTH, IMAGE_HEIGHT};
+    SDL_SetTextureColorMod(cover, 255, 255, 255);
+    SDL_SetTextureBlendMode(cover, SDL_BLENDMODE_BLEND);
+    renderFittedImage(renderer, cover, coverInfo, destRect);
+    FC_DrawAlign(font, renderer, position.x + IMAGE_WIDTH - 8, position.y + IMAGE_HEIGHT - FONT_SIZE - 8, FC_ALIGN_RIGHT, "%u", static_cast<unsigned>(pairCount));
+    FC_Rect nameBox = {position.x - SEPARATION / 2, position.y + IMAGE_HEIGHT + 8, IMAGE_WIDTH + SEPARATION, TILE_HEIGHT - IMAGE_HEIGHT - 8};
+    FC_DrawBoxAlign(font, renderer, nameBox, FC_ALIGN_CENTER, "%.*s", static_cast<int>(name.size()), name.data());
+}
 
-        if ((tvPath.empty() || std::filesystem::exists(tvPath)) || (drcPath.empty() || std::filesystem::exists(drcPath))) {
-            ImagesPair imgPair;
+// Deferred until the first frame is on screen so opening the audio device
+// and priming the stream stay off the critical path to first frame
+void startBackgroundMusic() {
+    static bool started = false;
+    if (started) {
+        return;
+    }
+    started = true;
 
-            imgPair.textureTV = loadTexture(renderer, tvPath);
-            imgPair.textureDRC = loadTexture(renderer, drcPath);
+    if (Mix_OpenAudio(MIX_DEFAULT_FREQUENCY, MIX_DEFAULT_FORMAT, MIX_DEFAULT_CHANNELS, 4096) != 0) {
+        return;
+    }
+    audioOpened = true;
 
-            imgPair.x = offsetX + (pairIndex - 1) % GRID_SIZE * (IMAGE_WIDTH + SEPARATION);
-            imgPair.y = offsetY + (pairIndex - 1) / GRID_SIZE * (IMAGE_WIDTH + SEPARATION);
+    SDL_RWops *rw = openMusicStream("romfs:/bg_music.mp3");
+    if (rw == nullptr) {
+        return;
+    }
+    backgroundMusic = Mix_LoadMUS_RW(rw, true);
+    if (backgroundMusic == nullptr) {
+        return;
+    }
+    Mix_VolumeMusic(SDL_MIX_MAXVOLUME * 0.15);
+    if (Mix_PlayMusic(backgroundMusic, -1) != 0) {
+        Mix_FreeMusic(backgroundMusic);
+        backgroundMusic = nullptr;
+    }
+}
+
+// Shows placeholders and the scan counters until a scan started with
+// std::async is done
+void waitForScan(SDL_Renderer *renderer, std::future<void> &scan, const ScanProgress &scanProgress, const std::string &title, MenuState state, int offsetX, int offsetY) {
+    while (scan.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready) {
+        int placeholderCount = static_cast<int>(scanProgress.getPairsFound());
+        SDL_RenderClear(renderer);
+        SDL_RenderCopy(renderer, backgroundTexture.texture, nullptr, &backgroundTexture.rect);
+        renderBackgroundParticles(renderer, particles, particleTexture);
+        for (int i = 0; i < placeholderCount && isImageVisible(i, offsetY, 0, false); i++) {
+            renderImage(renderer, placeholderTexture, placeholderTexture, nullptr, nullptr, getImagePosition(i, offsetX, offsetY, 0), false, state);
+        }
+        renderHeader(renderer, font, headerTexture, title);
+        FC_DrawAlign(font, renderer, SCREEN_WIDTH / 2, SCREEN_HEIGHT - 80, FC_ALIGN_CENTER, "Scanning... %u files, %u screenshots, %u loaded",
+                     static_cast<unsigned>(scanProgress.getFilesSeen()), static_cast<unsigned>(scanProgress.getPairsFound()), static_cast<unsigned>(scanProgress.getThumbnailsDecoded()));
+        SDL_RenderPresent(renderer);
+        startBackgroundMusic();
+    }
+}
 
-            imgPair.selected = false;
-            imgPair.pathTV = tvPath;
-            imgPair.pathDRC = drcPath;
+// Finds pairs of the opened folder whose files are byte-identical to another
+// pair anywhere under the root, and returns the grid positions of all but one
+// copy. A copy in another folder is the one kept if there is one, otherwise
+// the first in grid order. Runs on a worker while the UI only draws progress.
+void findDuplicatePairs(const std::string &rootPath, const std::string &folderPath, std::vector<uint32_t> &duplicates, DuplicateProgress *progress) {
+    struct PairFiles {
+        uint32_t tv;  // index into paths, UINT32_MAX for a missing half
+        uint32_t drc;
+        int32_t position; // in the grid, -1 outside the opened folder
+    };
+    std::vector<std::string> paths;
+    std::vector<uint8_t> wanted;
+    std::vector<PairFiles> pairs;
+    auto addFile = [&](std::string &&path, bool inFolder) {
+        if (path.empty()) {
+            return UINT32_MAX;
+        }
+        paths.push_back(std::move(path));
+        wanted.push_back(inFolder);
+        return static_cast<uint32_t>(paths.size() - 1);
+    };
+    for (uint32_t i = 0; i < displayOrder.size(); i++) {
+        uint32_t tv = addFile(library.getPathTV(displayOrder[i]), true);
+        uint32_t drc = addFile(library.getPathDRC(displayOrder[i]), true);
+        pairs.push_back({tv, drc, static_cast<int32_t>(i)});
+    }
+    ScreenshotScanner scanner;
+    scanner.scan(rootPath);
+    for (const auto &pair : scanner.getPairs()) {
+        if (scanner.getDirectory(pair.directory) == folderPath) {
+            continue;
+        }
+        uint32_t tv = pair.tvFormat == ImageFormat::Unknown ? UINT32_MAX : addFile(scanner.buildPath(pair, ScreenshotKind::TV), false);
+        uint32_t drc = pair.drcFormat == ImageFormat::Unknown ? UINT32_MAX : addFile(scanner.buildPath(pair, ScreenshotKind::DRC), false);
+        pairs.push_back({tv, drc, -1});
+    }
 
-            imagePairs.push_back(imgPair);
-            ++pairIndex;
-            totalImagesMutex.lock();
-            ++(*totalImages);
-            totalImagesMutex.unlock();
+    std::vector<uint32_t> groups = findDuplicateFiles(paths, wanted, *progress);
+    // A pair is a copy when every half it has is one, and it lacks the same halves
+    auto groupOf = [&](uint32_t file) { return file == UINT32_MAX ? UINT32_MAX - 1 : groups[file]; };
+    pairs.erase(std::remove_if(pairs.begin(), pairs.end(), [&](const PairFiles &pair) {
+        return groupOf(pair.tv) == DUPLICATE_GROUP_NONE || groupOf(pair.drc) == DUPLICATE_GROUP_NONE;
+    }), pairs.end());
+    std::sort(pairs.begin(), pairs.end(), [&](const PairFiles &a, const PairFiles &b) {
+        if (groupOf(a.tv) != groupOf(b.tv)) {
+            return groupOf(a.tv) < groupOf(b.tv);
+        }
+        if (groupOf(a.drc) != groupOf(b.drc)) {
+            return groupOf(a.drc) < groupOf(b.drc);
+        }
+        return a.position < b.position;
+    });
+    for (size_t first = 0; first < pairs.size();) {
+        size_t last = first + 1;
+        while (last < pairs.size() && groupOf(pairs[last].tv) == groupOf(pairs[first].tv) && groupOf(pairs[last].drc) == groupOf(pairs[first].drc)) {
+            last++;
+        }
+        for (size_t i = first + 1; i < last; i++) {
+            if (pairs[i].position >= 0) {
+                duplicates.push_back(pairs[i].position);
+            }
         }
+        first = last;
     }
+}
 
-    return imagePairs;
+// Selects every exact copy in the opened folder, ready to be deleted
+void selectDuplicates(SDL_Renderer *renderer, const std::string &title, const std::string &folderPath) {
+    DuplicateProgress progress;
+    std::vector<uint32_t> duplicates;
+    std::future<void> finding = std::async(std::launch::async, findDuplicatePairs, std::cref(imagePath), std::cref(folderPath), std::ref(duplicates), &progress);
+    while (finding.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready) {
+        SDL_RenderClear(renderer);
+        SDL_RenderCopy(renderer, backgroundTexture.texture, nullptr, &backgroundTexture.rect);
+        renderBackgroundParticles(renderer, particles, particleTexture);
+        renderHeader(renderer, font, headerTexture, title);
+        FC_DrawAlign(font, renderer, SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2, FC_ALIGN_CENTER, "Finding duplicates... %u files checked, %u / %u compared",
+                     static_cast<unsigned>(progress.filesSized.load(std::memory_order_relaxed)), static_cast<unsigned>(progress.filesHashed.load(std::memory_order_relaxed)),
+                     static_cast<unsigned>(progress.filesToHash.load(std::memory_order_relaxed)));
+        SDL_RenderPresent(renderer);
+    }
+    finding.get();
+    selection.clear();
+    for (uint32_t position : duplicates) {
+        selection.set(position, true);
+    }
 }
 
-SDL_GameController *findController() {
-    for (int i = 0; i < SDL_NumJoysticks(); i++) {
-        if (SDL_IsGameController(i)) {
-            return SDL_GameControllerOpen(i);
+// Asks whether the selection goes out as loose files, one archive or a
+// contact sheet, or is optimized where it is
+SelectionAction chooseSelectionAction(SDL_Renderer *renderer, const std::string &title) {
+    while (true) {
+        SDL_Event event;
+        while (SDL_PollEvent(&event)) {
+            if (event.type == SDL_FINGERDOWN) {
+                return SelectionAction::Cancelled;
+            }
+            if (event.type != SDL_CONTROLLERBUTTONDOWN) {
+                continue;
+            }
+            switch (event.cbutton.button) {
+                case SDL_CONTROLLER_BUTTON_A:
+                    return SelectionAction::CopyFiles;
+                case SDL_CONTROLLER_BUTTON_Y:
+                    return SelectionAction::Archive;
+                case SDL_CONTROLLER_BUTTON_X:
+                    return SelectionAction::ContactSheet;
+                case SDL_CONTROLLER_BUTTON_BACK:
+                    return SelectionAction::Optimize;
+                case SDL_CONTROLLER_BUTTON_B:
+                    return SelectionAction::Cancelled;
+            }
         }
+        SDL_RenderClear(renderer);
+        SDL_RenderCopy(renderer, backgroundTexture.texture, nullptr, &backgroundTexture.rect);
+        renderBackgroundParticles(renderer, particles, particleTexture);
+        renderHeader(renderer, font, headerTexture, title);
+        FC_DrawAlign(font, renderer, SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2, FC_ALIGN_CENTER, "%u screenshots selected", static_cast<unsigned>(selection.count()));
+        FC_DrawAlign(font, renderer, SCREEN_WIDTH / 2, SCREEN_HEIGHT - 80, FC_ALIGN_CENTER, BUTTON_A " Copy files    " BUTTON_Y " ZIP archive    " BUTTON_X " Contact sheet    " BUTTON_MINUS " Optimize    " BUTTON_B " Cancel");
+        SDL_RenderPresent(renderer);
     }
+}
 
-    return nullptr;
+// Copies both halves of every selected pair into a folder named after the
+// opened one, or streams them into "<folder>_<date>.zip" next to it. B or a
+// tap cancels.
+void exportSelection(SDL_Renderer *renderer, const std::string &title, bool archive) {
+    std::string destination = EXPORT_PATH;
+    if (!archive) {
+        destination += "/" + title;
+    }
+    std::error_code error;
+    std::filesystem::create_directories(destination, error);
+    std::vector<ExportFile> files;
+    std::vector<ZipEntrySource> entries;
+    selection.forEachSelected([&](size_t index) {
+        for (ScreenshotKind kind : {ScreenshotKind::TV, ScreenshotKind::DRC}) {
+            std::string source;
+            library.buildPath(displayOrder[index], kind, source);
+            if (source.empty()) {
+                continue;
+            }
+            std::string name = source.substr(source.rfind('/') + 1);
+            if (archive) {
+                entries.push_back({std::move(source), std::move(name), library.getCaptureTime(displayOrder[index])});
+            } else {
+                files.push_back({std::move(source), destination + "/" + name});
+            }
+        }
+    });
+    if (archive) {
+        char stamp[32];
+        time_t now = time(nullptr);
+        strftime(stamp, sizeof(stamp), "_%Y-%m-%d_%H-%M-%S.zip", localtime(&now));
+        destination += "/" + title + stamp;
+    }
+    unsigned fileCount = archive ? entries.size() : files.size();
+
+    ExportProgress progress;
+    Uint32 startTicks = SDL_GetTicks();
+    std::future<bool> exporting = archive ? std::async(std::launch::async, writeZipArchive, std::cref(entries), std::cref(destination), std::ref(progress))
+                                          : std::async(std::launch::async, exportFiles, std::cref(files), std::ref(progress));
+    while (exporting.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready) {
+        SDL_Event event;
+        while (SDL_PollEvent(&event)) {
+            if ((event.type == SDL_CONTROLLERBUTTONDOWN && event.cbutton.button == SDL_CONTROLLER_BUTTON_B) || event.type == SDL_FINGERDOWN) {
+                progress.cancelled.store(true);
+            }
+        }
+        float seconds = std::max(SDL_GetTicks() - startTicks, 1u) / 1000.0f;
+        float copiedMB = progress.bytesCopied.load(std::memory_order_relaxed) / (1024.0f * 1024.0f);
+        SDL_RenderClear(renderer);
+        SDL_RenderCopy(renderer, backgroundTexture.texture, nullptr, &backgroundTexture.rect);
+        renderBackgroundParticles(renderer, particles, particleTexture);
+        renderHeader(renderer, font, headerTexture, title);
+        FC_DrawAlign(font, renderer, SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2, FC_ALIGN_CENTER, "%s... %u / %u files    %.1f / %.1f MB    %.1f MB/s", archive ? "Archiving" : "Exporting",
+                     static_cast<unsigned>(progress.filesCopied.load(std::memory_order_relaxed) + progress.filesFailed.load(std::memory_order_relaxed)), static_cast<unsigned>(fileCount), copiedMB,
+                     progress.bytesTotal.load(std::memory_order_relaxed) / (1024.0f * 1024.0f), copiedMB / seconds);
+        FC_DrawAlign(font, renderer, SCREEN_WIDTH / 2, SCREEN_HEIGHT - 80, FC_ALIGN_CENTER, progress.cancelled.load() ? "Cancelling..." : BUTTON_B " Cancel");
+        SDL_RenderPresent(renderer);
+    }
+    exporting.get();
+
+    uint32_t copied = progress.filesCopied.load();
+    uint32_t failed = progress.filesFailed.load();
+    if (progress.cancelled.load() && archive) {
+        setStatusMessage("Archive cancelled, nothing was written");
+    } else if (progress.cancelled.load()) {
+        setStatusMessage("Export cancelled, %u of %u files copied", static_cast<unsigned>(copied), static_cast<unsigned>(fileCount));
+    } else if (archive && copied == 0) {
+        setStatusMessage("Could not write %s", destination.c_str());
+    } else if (failed > 0) {
+        setStatusMessage("Exported %u files, %u failed", static_cast<unsigned>(copied), static_cast<unsigned>(failed));
+    } else {
+        setStatusMessage("Exported %u files to %s", static_cast<unsigned>(copied), destination.c_str());
+    }
 }
 
-void renderHeader(SDL_Renderer *renderer, FC_Font *font, const Texture &headerTexture) {
-    SDL_SetTextureColorMod(headerTexture.texture, 0, 0, 147);
-    SDL_SetTextureBlendMode(headerTexture.texture, SDL_BLENDMODE_BLEND);
-    SDL_RenderCopy(renderer, headerTexture.texture, nullptr, &headerTexture.rect);
-    FC_DrawColor(font, renderer, headerTexture.rect.x + (headerTexture.rect.w / 2), (headerTexture.rect.y + (headerTexture.rect.h / 2)) - 100, SCREEN_COLOR_WHITE, "Album");
+// Renders the selected pairs, or the whole opened folder, into one PNG next
+// to the exports. Writing into the screenshot folder would change its time
+// and force a rescan. The TV half stands for a pair when it has one.
+void createContactSheet(SDL_Renderer *renderer, const std::string &title, bool selectedOnly) {
+    std::vector<std::string> paths;
+    for (uint32_t i = 0; i < displayOrder.size(); i++) {
+        if (selectedOnly && !selection.isSelected(i)) {
+            continue;
+        }
+        std::string path = library.getPathTV(displayOrder[i]);
+        paths.push_back(path.empty() ? library.getPathDRC(displayOrder[i]) : std::move(path));
+    }
+    char stamp[64];
+    time_t now = time(nullptr);
+    strftime(stamp, sizeof(stamp), "_contact_sheet_%Y-%m-%d_%H-%M-%S.png", localtime(&now));
+    std::error_code error;
+    std::filesystem::create_directories(EXPORT_PATH, error);
+    std::string outputPath = EXPORT_PATH "/" + title + stamp;
+
+    ContactSheetProgress progress;
+    std::future<bool> writing = std::async(std::launch::async, writeContactSheet, std::cref(paths), std::cref(outputPath), std::ref(progress));
+    while (writing.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready) {
+        SDL_Event event;
+        while (SDL_PollEvent(&event)) {
+            if ((event.type == SDL_CONTROLLERBUTTONDOWN && event.cbutton.button == SDL_CONTROLLER_BUTTON_B) || event.type == SDL_FINGERDOWN) {
+                progress.cancelled.store(true);
+            }
+        }
+        SDL_RenderClear(renderer);
+        SDL_RenderCopy(renderer, backgroundTexture.texture, nullptr, &backgroundTexture.rect);
+        renderBackgroundParticles(renderer, particles, particleTexture);
+        renderHeader(renderer, font, headerTexture, title);
+        FC_DrawAlign(font, renderer, SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2, FC_ALIGN_CENTER, "Creating contact sheet... %u / %u screenshots",
+                     static_cast<unsigned>(progress.cellsDone.load(std::memory_order_relaxed)), static_cast<unsigned>(paths.size()));
+        FC_DrawAlign(font, renderer, SCREEN_WIDTH / 2, SCREEN_HEIGHT - 80, FC_ALIGN_CENTER, progress.cancelled.load() ? "Cancelling..." : BUTTON_B " Cancel");
+        SDL_RenderPresent(renderer);
+    }
+    bool written = writing.get();
+
+    if (progress.cancelled.load()) {
+        setStatusMessage("Contact sheet cancelled");
+    } else if (!written) {
+        setStatusMessage("Could not write %s", outputPath.c_str());
+    } else if (progress.cellsFailed.load() > 0) {
+        setStatusMessage("Saved contact sheet of %u screenshots, %u could not be read", static_cast<unsigned>(paths.size()), static_cast<unsigned>(progress.cellsFailed.load()));
+    } else {
+        setStatusMessage("Saved contact sheet of %u screenshots to %s", static_cast<unsigned>(paths.size()), outputPath.c_str());
+    }
 }
 
-void renderImage(SDL_Renderer *renderer, const ImagesPair &image, int scrollOffsetY, MenuState state) {
-    SDL_Rect destRectTV = {image.x, headerTexture.rect.h + image.y + scrollOffsetY, IMAGE_WIDTH, IMAGE_HEIGHT};
-    SDL_Rect destRectDRC = {image.x + IMAGE_WIDTH / 2, headerTexture.rect.h + image.y + scrollOffsetY + IMAGE_WIDTH / 2, IMAGE_WIDTH / 2, IMAGE_HEIGHT / 2};
-    if (image.selected) {
-        SDL_SetTextureColorMod(image.textureTV, 0, 255, 0);
-        SDL_SetTextureColorMod(image.textureDRC, 0, 255, 0);
+// Re-encodes the PNG and BMP halves of the selected pairs, or of the whole
+// opened folder, after asking how. The library is pointed at the new files in
+// place. Returns whether any pair was converted.
+bool optimizeStorage(SDL_Renderer *renderer, const std::string &title, bool selectedOnly, ThumbnailScheduler &scheduler, TextureUploadQueue &uploadQueue,
+                     MetadataProber &prober) {
+    std::vector<SlotHandle> handles;
+    std::vector<OptimizeJob> jobs;
+    for (uint32_t i = 0; i < displayOrder.size(); i++) {
+        SlotHandle handle = displayOrder[i];
+        if ((selectedOnly && !selection.isSelected(i)) ||
+            (!isOptimizable(library.getFormat(handle, ScreenshotKind::TV)) && !isOptimizable(library.getFormat(handle, ScreenshotKind::DRC)))) {
+            continue;
+        }
+        handles.push_back(handle);
+        jobs.push_back({library.getPathTV(handle), library.getPathDRC(handle)});
+    }
+    if (jobs.empty()) {
+        setStatusMessage("No PNG or BMP screenshots to optimize");
+        return false;
+    }
+
+    OptimizeMode mode = OptimizeMode::Jpeg;
+    bool chosen = false;
+    while (!chosen) {
+        SDL_Event event;
+        while (SDL_PollEvent(&event)) {
+            if (event.type == SDL_FINGERDOWN || (event.type == SDL_CONTROLLERBUTTONDOWN && event.cbutton.button == SDL_CONTROLLER_BUTTON_B)) {
+                return false;
+            }
+            if (event.type == SDL_CONTROLLERBUTTONDOWN && (event.cbutton.button == SDL_CONTROLLER_BUTTON_A || event.cbutton.button == SDL_CONTROLLER_BUTTON_Y)) {
+                mode = event.cbutton.button == SDL_CONTROLLER_BUTTON_A ? OptimizeMode::Jpeg : OptimizeMode::Lossless;
+                chosen = true;
+            }
+        }
+        SDL_RenderClear(renderer);
+        SDL_RenderCopy(renderer, backgroundTexture.texture, nullptr, &backgroundTexture.rect);
+        renderBackgroundParticles(renderer, particles, particleTexture);
+        renderHeader(renderer, font, headerTexture, title);
+        FC_DrawAlign(font, renderer, SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2, FC_ALIGN_CENTER, "%u screenshots are stored as PNG or BMP", static_cast<unsigned>(jobs.size()));
+        FC_DrawAlign(font, renderer, SCREEN_WIDTH / 2, SCREEN_HEIGHT - 80, FC_ALIGN_CENTER, BUTTON_A " Convert to JPEG    " BUTTON_Y " Recompress as PNG    " BUTTON_B " Cancel");
+        SDL_RenderPresent(renderer);
+    }
+
+    // A file still open in a decode or probe would fail its rename and roll
+    // the pair back; both are queued again afterwards
+    resetThumbnails(scheduler, uploadQueue);
+    scheduler.waitUntilIdle();
+    prober.reset();
+    prober.waitUntilIdle();
+
+    OptimizeProgress progress;
+    std::vector<OptimizeResult> results;
+    Uint32 startTicks = SDL_GetTicks();
+    std::future<void> optimizing = std::async(std::launch::async, optimizePairs, std::cref(jobs), mode, std::ref(results), std::ref(progress));
+    while (optimizing.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready) {
+        SDL_Event event;
+        while (SDL_PollEvent(&event)) {
+            if ((event.type == SDL_CONTROLLERBUTTONDOWN && event.cbutton.button == SDL_CONTROLLER_BUTTON_B) || event.type == SDL_FINGERDOWN) {
+                progress.cancelled.store(true);
+            }
+        }
+        float seconds = std::max(SDL_GetTicks() - startTicks, 1u) / 1000.0f;
+        float readMB = progress.bytesRead.load(std::memory_order_relaxed) / (1024.0f * 1024.0f);
+        float savedMB = readMB - progress.bytesWritten.load(std::memory_order_relaxed) / (1024.0f * 1024.0f);
+        SDL_RenderClear(renderer);
+        SDL_RenderCopy(renderer, backgroundTexture.texture, nullptr, &backgroundTexture.rect);
+        renderBackgroundParticles(renderer, particles, particleTexture);
+        renderHeader(renderer, font, headerTexture, title);
+        FC_DrawAlign(font, renderer, SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2, FC_ALIGN_CENTER, "Optimizing... %u / %u    %.1f MB saved    %.1f MB/s",
+                     static_cast<unsigned>(progress.pairsDone.load(std::memory_order_relaxed)), static_cast<unsigned>(jobs.size()), savedMB, readMB / seconds);
+        FC_DrawAlign(font, renderer, SCREEN_WIDTH / 2, SCREEN_HEIGHT - 80, FC_ALIGN_CENTER, progress.cancelled.load() ? "Cancelling..." : BUTTON_B " Cancel");
+        SDL_RenderPresent(renderer);
+    }
+    optimizing.get();
+
+    uint32_t converted = 0;
+    for (size_t i = 0; i < results.size(); i++) {
+        if (results[i].optimized) {
+            library.setFormat(handles[i], ScreenshotKind::TV, results[i].tvFormat);
+            library.setFormat(handles[i], ScreenshotKind::DRC, results[i].drcFormat);
+            converted++;
+        }
+    }
+    // The cache records formats, so it has to be written again
+    hashCacheDirty = hashCacheDirty || converted > 0;
+    reloadOptimizedPairs(scheduler, uploadQueue, prober);
+    float seconds = std::max(SDL_GetTicks() - startTicks, 1u) / 1000.0f;
+    float readMB = progress.bytesRead.load() / (1024.0f * 1024.0f);
+    float savedMB = readMB - progress.bytesWritten.load() / (1024.0f * 1024.0f);
+    uint32_t failed = progress.pairsFailed.load();
+    if (failed > 0) {
+        setStatusMessage("Optimized %u of %u screenshots, saved %.1f MB at %.1f MB/s, %u failed", static_cast<unsigned>(converted), static_cast<unsigned>(jobs.size()), savedMB, readMB / seconds,
+                         static_cast<unsigned>(failed));
     } else {
-        SDL_SetTextureColorMod(image.textureTV, 255, 255, 255);
-        SDL_SetTextureColorMod(image.textureDRC, 255, 255, 255);
+        setStatusMessage("Optimized %u of %u screenshots, saved %.1f MB at %.1f MB/s", static_cast<unsigned>(converted), static_cast<unsigned>(jobs.size()), savedMB, readMB / seconds);
     }
-    SDL_SetTextureBlendMode(image.textureTV, SDL_BLENDMODE_BLEND);
-    SDL_SetTextureBlendMode(image.textureDRC, SDL_BLENDMODE_BLEND);
-    SDL_RenderCopy(renderer, image.textureTV, nullptr, &destRectTV);
-    SDL_RenderCopy(renderer, image.textureDRC, nullptr, &destRectDRC);
-    if (state == MenuState::SelectImagesDelete) {
-        drawOrb(renderer, image.x - 10, headerTexture.rect.h + image.y + scrollOffsetY - 10, 60, image.selected);
+    return converted > 0;
+}
+
+// Plays the opened folder from the selected pair on, looping, with the TV
+// half standing for each pair. A pauses, left and right step, and B or a tap
+// ends the show on the pair in view.
+void runSlideshow(SDL_Renderer *renderer, TextureUploadQueue &uploadQueue, int &selectedImageIndex) {
+    std::vector<SlideSource> sources;
+    sources.reserve(displayOrder.size());
+    for (SlotHandle handle : displayOrder) {
+        ScreenshotKind kind = library.getFlags(handle) & IMAGE_FLAG_HAS_TV ? ScreenshotKind::TV : ScreenshotKind::DRC;
+        const ImageInfo *info = library.getInfo(handle, kind);
+        SlideSource source{{}, info ? info->orientation : static_cast<uint8_t>(1)};
+        library.buildPath(handle, kind, source.path);
+        sources.push_back(std::move(source));
+    }
+    Slideshow slideshow(renderer, std::move(sources), selectedImageIndex);
+    bool running = true;
+    while (running) {
+        // Keeps the upload budget tracking frames while the grid is away
+        uploadQueue.beginFrame();
+        SDL_Event event;
+        while (SDL_PollEvent(&event)) {
+            if (event.type == SDL_FINGERDOWN) {
+                running = false;
+            }
+            if (event.type != SDL_CONTROLLERBUTTONDOWN) {
+                continue;
+            }
+            switch (event.cbutton.button) {
+                case SDL_CONTROLLER_BUTTON_A:
+                    slideshow.togglePaused();
+                    break;
+                case SDL_CONTROLLER_BUTTON_B:
+                    running = false;
+                    break;
+                case SDL_CONTROLLER_BUTTON_DPAD_LEFT:
+                    slideshow.step(-1);
+                    break;
+                case SDL_CONTROLLER_BUTTON_DPAD_RIGHT:
+                    slideshow.step(1);
+                    break;
+            }
+        }
+        Uint32 now = SDL_GetTicks();
+        slideshow.update(now);
+        SDL_RenderClear(renderer);
+        drawRectFilled(renderer, 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, SCREEN_COLOR_BLACK);
+        slideshow.render(now);
+        if (slideshow.isPaused()) {
+            FC_DrawAlign(font, renderer, SCREEN_WIDTH / 2, SCREEN_HEIGHT - 80, FC_ALIGN_CENTER, "Paused    " BUTTON_A " Resume    " BUTTON_DPAD " Step    " BUTTON_B " Back");
+        }
+        uploadQueue.endFrame();
+        SDL_RenderPresent(renderer);
     }
+    selectedImageIndex = slideshow.getCurrentSource();
 }
 
-int32_t loadFile(const char *fPath, uint8_t **buf) {
-    int ret = 0;
-    FILE *file = fopen(fPath, "rb");
-    if (file != nullptr) {
-        struct stat st {};
-        stat(fPath, &st);
-        int size = st.st_size;
+// Hashes the pairs the grid has not decoded yet, then selects every shot of
+// each burst except the sharpest one
+void selectSimilar(SDL_Renderer *renderer, const std::string &title) {
+    std::vector<uint32_t> missing;
+    std::vector<std::string> paths;
+    for (uint32_t i = 0; i < displayOrder.size(); i++) {
+        SlotHandle handle = displayOrder[i];
+        if (!(library.getFlags(handle) & IMAGE_FLAG_HASHED)) {
+            missing.push_back(i);
+            paths.emplace_back();
+            library.buildPath(handle, library.getHashedKind(handle), paths.back());
+        }
+    }
+    if (!missing.empty()) {
+        std::vector<PerceptualHash> hashes;
+        std::vector<uint8_t> valid;
+        std::atomic<uint32_t> done{0};
+        std::future<void> hashing = std::async(std::launch::async, hashImages, std::cref(paths), IMAGE_WIDTH, IMAGE_HEIGHT, std::ref(hashes), std::ref(valid), std::ref(done));
+        while (hashing.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready) {
+            SDL_RenderClear(renderer);
+            SDL_RenderCopy(renderer, backgroundTexture.texture, nullptr, &backgroundTexture.rect);
+            renderBackgroundParticles(renderer, particles, particleTexture);
+            renderHeader(renderer, font, headerTexture, title);
+            FC_DrawAlign(font, renderer, SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2, FC_ALIGN_CENTER, "Finding similar screenshots... %u / %u", static_cast<unsigned>(done.load(std::memory_order_relaxed)),
+                         static_cast<unsigned>(paths.size()));
+            SDL_RenderPresent(renderer);
+        }
+        hashing.get();
+        for (size_t i = 0; i < missing.size(); i++) {
+            if (valid[i]) {
+                library.setPerceptualHash(displayOrder[missing[i]], hashes[i]);
+                hashCacheDirty = true;
+            }
+        }
+    }
 
-        *buf = (uint8_t *) malloc(size);
-        if (*buf != nullptr) {
-            if (fread(*buf, size, 1, file) == 1)
-                ret = size;
-            else
-                free(*buf);
+    std::vector<uint32_t> positions;
+    std::vector<uint64_t> bits;
+    positions.reserve(displayOrder.size());
+    bits.reserve(displayOrder.size());
+    for (uint32_t i = 0; i < displayOrder.size(); i++) {
+        if (library.getFlags(displayOrder[i]) & IMAGE_FLAG_HASHED) {
+            positions.push_back(i);
+            bits.push_back(library.getPerceptualHash(displayOrder[i]).bits);
+        }
+    }
+    selection.clear();
+    for (const auto &cluster : findSimilarClusters(bits, SIMILAR_MAX_DISTANCE)) {
+        // Members are in grid order, so the first of equally sharp shots stays
+        uint32_t best = cluster[0];
+        for (uint32_t member : cluster) {
+            if (library.getPerceptualHash(displayOrder[positions[member]]).sharpness > library.getPerceptualHash(displayOrder[positions[best]]).sharpness) {
+                best = member;
+            }
+        }
+        for (uint32_t member : cluster) {
+            if (member != best) {
+                selection.set(positions[member], true);
+            }
         }
-        fclose(file);
     }
-    return ret;
 }
 
 int main() {
@@ -411,21 +1292,6 @@ int main() {
     SDL_Window *window = SDL_CreateWindow(nullptr, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, 0, 0, SDL_WINDOW_FULLSCREEN_DESKTOP);
     SDL_Renderer *renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
 
-    int bgMusicFileSize = loadFile("romfs:/bg_music.mp3", &bgmBuffer);
-    if (Mix_OpenAudio(MIX_DEFAULT_FREQUENCY, MIX_DEFAULT_FORMAT, MIX_DEFAULT_CHANNELS, 4096) == 0) {
-        SDL_RWops *rw = SDL_RWFromMem(bgmBuffer, bgMusicFileSize);
-        backgroundMusic = Mix_LoadMUS_RW(rw, true);
-        if (backgroundMusic != NULL) {
-            Mix_VolumeMusic(SDL_MIX_MAXVOLUME * 0.15);
-            Mix_PlayMusic(backgroundMusic, -1);
-            if (Mix_PlayMusic(backgroundMusic, -1) != 0) {
-                Mix_FreeMusic(backgroundMusic);
-                bgmBuffer = nullptr;
-                Mix_CloseAudio();
-            }
-        }
-    }
-
     OSSetThreadPriority(OSGetCurrentThread(), THREAD_PRIORITY_HIGH);
 
     void *ttf;
@@ -464,118 +1330,156 @@ int main() {
 
     SDL_SetRenderTarget(renderer, nullptr);
 
+    thumbnailPool = std::make_unique<TexturePool>(renderer, IMAGE_WIDTH, IMAGE_HEIGHT, THUMBNAIL_POOL_SIZE);
+
     int selectedImageIndex = 0;
     int scrollOffsetY = 0;
+    ScrollEngine scrollEngine;
 
-    MenuState state = MenuState::ShowAllImages;
+    MenuState state = MenuState::ShowFolders;
 
-    arrowTexture = IMG_LoadTexture(renderer, "romfs:/arrow_image.png");
+    AssetPack uiAssets;
+    uiAssets.open(ASSET_PACK_PATH);
+    arrowTexture = uiAssets.loadTexture(renderer, "arrow_image");
     if (!arrowTexture) {
         SDL_Quit();
         return 1;
     }
-    backgroundTexture.texture = IMG_LoadTexture(renderer, "romfs:/backdrop.png");
+    backgroundTexture.texture = uiAssets.loadTexture(renderer, "backdrop");
     if (!backgroundTexture.texture) {
         SDL_Quit();
         return 1;
     }
-    cornerButtonTexture = IMG_LoadTexture(renderer, "romfs:/corner-button.png");
+    cornerButtonTexture = uiAssets.loadTexture(renderer, "corner-button");
     if (!cornerButtonTexture) {
         SDL_Quit();
         return 1;
     }
-    largeCornerButtonTexture = IMG_LoadTexture(renderer, "romfs:/large-corner-button.png");
+    largeCornerButtonTexture = uiAssets.loadTexture(renderer, "large-corner-button");
     if (!largeCornerButtonTexture) {
         SDL_Quit();
         return 1;
     }
-    backGraphicTexture.texture = IMG_LoadTexture(renderer, "romfs:/back_graphic.png");
+    backGraphicTexture.texture = uiAssets.loadTexture(renderer, "back_graphic");
     if (!backGraphicTexture.texture) {
         SDL_Quit();
         return 1;
     }
-    headerTexture.texture = IMG_LoadTexture(renderer, "romfs:/header.png");
+    headerTexture.texture = uiAssets.loadTexture(renderer, "header");
     if (!headerTexture.texture) {
         SDL_Quit();
         return 1;
     }
-    orbTexture = IMG_LoadTexture(renderer, "romfs:/orb.png");
+    orbTexture = uiAssets.loadTexture(renderer, "orb");
     if (!orbTexture) {
         SDL_Quit();
         return 1;
     }
-    particleTexture = IMG_LoadTexture(renderer, "romfs:/orb.png");
-    if (!particleTexture) {
-        SDL_Quit();
-        return 1;
-    }
-    pointerTexture.texture = IMG_LoadTexture(renderer, "romfs:/orb.png");
-    if (!pointerTexture.texture) {
-        SDL_Quit();
-        return 1;
-    }
+    // One decode of the orb serves all three, each use sets its own color
+    particleTexture = orbTexture;
+    pointerTexture.texture = orbTexture;
 
     backgroundTexture.rect = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
     backGraphicTexture.rect = {0, SCREEN_HEIGHT - 128, 128, 128};
     headerTexture.rect = {0, 0, SCREEN_WIDTH, 256};
     pointerTexture.rect = {0, 0, 30, 30};
+    uiAssets.close();
 
     bool deleteImagesSelected = false;
-
-    int totalImages = 0;
-    MutexWrapper totalImagesMutex = MutexWrapper();
-    totalImagesMutex.init("totalImages");
-
-    std::vector<ImagesPair> placeholderImages;
-    std::future<std::vector<ImagesPair>> futureImages = std::async(std::launch::async, scanImagePairsInSubfolders, renderer, imagePath, offsetX, offsetY, &totalImages, totalImagesMutex);
-    std::vector<ImagesPair> images;
+    bool closeFolderSelected = false;
+
+    ScanProgress scanProgress;
+
+    // Startup only lists the top level; a folder's pairs are scanned when it is opened
+    FolderIndex folderIndex(imagePath);
+    std::future<void> futureFolders = std::async(std::launch::async, &FolderIndex::refresh, &folderIndex, &scanProgress);
+    auto thumbnailScheduler = std::make_unique<ThumbnailScheduler>(IMAGE_WIDTH, IMAGE_HEIGHT, &scanProgress);
+    TextureUploadQueue uploadQueue;
+    MetadataProber metadataProber;
+    ImagePairScreen imagePairScreen(&library, arrowTexture, renderer, font);
+    // The thumbnails stand in until the full resolution images are loaded
+    imagePairScreen.setThumbnailFunction([](SlotHandle handle, ScreenshotKind kind) {
+        return getThumbnailTexture(kind == ScreenshotKind::TV ? library.getThumbnailTV(handle) : library.getThumbnailDRC(handle));
+    });
 
     Button cornerButton(0, SCREEN_HEIGHT - 137, 185, 137, cornerButtonTexture, font, "", SCREEN_COLOR_WHITE);
     cornerButton.setOnClick([&]() {
-        state = MenuState::ShowAllImages;
-        if (std::any_of(images.begin(), images.end(), [](const ImagesPair &image) { return image.selected; })) {
-            for (auto &image : images) {
-                image.selected = false;
-            }
+        if (state == MenuState::ShowFolders) {
+            return;
         }
+        if (state == MenuState::ShowAllImages) {
+            closeFolderSelected = true;
+            return;
+        }
+        if (state == MenuState::ShowSingleImage) {
+            imagePairScreen.releaseTextures();
+        }
+        state = MenuState::ShowAllImages;
+        selection.clear();
     });
     cornerButton.setControllerButton(SDL_CONTROLLER_BUTTON_B);
 
-    ImagesPair placeholderImgPair;
-    placeholderImgPair.textureTV = placeholderTexture;
-    placeholderImgPair.textureDRC = placeholderTexture;
-    placeholderImgPair.selected = false;
-    placeholderImgPair.pathTV = "";
-    placeholderImgPair.pathDRC = "";
-
-    while (futureImages.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready) {
-        totalImagesMutex.lock();
-        int newImagesFound = totalImages - placeholderImages.size();
-        totalImagesMutex.unlock();
-        if (newImagesFound > 0) {
-            for (int i = 0; i < newImagesFound; i++) {
-                placeholderImgPair.x = offsetX + (placeholderImages.size() % GRID_SIZE) * (IMAGE_WIDTH + SEPARATION);
-                placeholderImgPair.y = offsetY + (placeholderImages.size() / GRID_SIZE) * (IMAGE_WIDTH + SEPARATION);
-                placeholderImages.push_back(placeholderImgPair);
-            }
-        }
-        SDL_RenderClear(renderer);
-        SDL_RenderCopy(renderer, backgroundTexture.texture, nullptr, &backgroundTexture.rect);
-        renderBackgroundParticles(renderer, particles, particleTexture);
-        for (const auto &image : placeholderImages) {
-            renderImage(renderer, image, scrollOffsetY, state);
+    waitForScan(renderer, futureFolders, scanProgress, "Album", state, offsetX, offsetY);
+    futureFolders.get();
+    loadFolderCovers(folderIndex);
+    sortFolders(folderIndex, sortMode);
+    probeMetadata(metadataProber, displayOrder);
+    updateScrollBounds(scrollEngine, displayOrder.size(), offsetY);
+    TrashBin trashBin(imagePath);
+
+    // Index into folderIndex while a folder is open, -1 on the folder grid
+    int openedFolder = -1;
+    float folderScrollOffset = 0.0f;
+    auto openFolder = [&](int folder) {
+        folderScrollOffset = scrollEngine.getOffset();
+        clearGrid(*thumbnailScheduler, uploadQueue, metadataProber);
+        scanProgress.reset();
+        // Refilled in place: the cleared library bumped every slot's
+        // generation, so handles from the folder grid stay stale
+        std::vector<SlotHandle> scannedOrder;
+        bool cacheStale = false;
+        std::future<void> futureImages = std::async(std::launch::async, scanImagePairsInFolder, folderIndex.getPath(folder), std::ref(library), std::ref(scannedOrder),
+                                                    std::ref(cacheStale), &scanProgress);
+        std::string title(folderIndex.getDisplayName(folder));
+        waitForScan(renderer, futureImages, scanProgress, title, MenuState::ShowAllImages, offsetX, offsetY);
+        futureImages.get();
+        displayOrder = std::move(scannedOrder);
+        hashCacheDirty = cacheStale;
+        sortImages(sortMode);
+        probeMetadata(metadataProber, displayOrder);
+        selection.resize(displayOrder.size());
+        openedFolder = folder;
+        updateFolderEntry(folderIndex, openedFolder);
+        selectedImageIndex = 0;
+        updateScrollBounds(scrollEngine, displayOrder.size(), offsetY);
+        scrollEngine.jumpTo(0.0f);
+        state = MenuState::ShowAllImages;
+    };
+    auto closeFolder = [&]() {
+        // Undo restores into the folder's library, which is about to go away
+        trashBin.beginBatch();
+        lastTrashedPairs.clear();
+        folderIndex.save();
+        if (hashCacheDirty) {
+            saveHashCache(folderIndex.getPath(openedFolder), library, displayOrder);
+            hashCacheDirty = false;
         }
-        renderHeader(renderer, font, headerTexture);
-        SDL_RenderPresent(renderer);
-    }
-
-    images = futureImages.get();
-    placeholderImages.clear();
-    placeholderImages.shrink_to_fit();
+        clearGrid(*thumbnailScheduler, uploadQueue, metadataProber);
+        loadFolderCovers(folderIndex);
+        sortFolders(folderIndex, sortMode);
+        probeMetadata(metadataProber, displayOrder);
+        // A folder emptied by deletes has no tile any more
+        auto opened = std::find(folderOrder.begin(), folderOrder.end(), openedFolder);
+        selectedImageIndex = opened == folderOrder.end() ? 0 : opened - folderOrder.begin();
+        openedFolder = -1;
+        updateScrollBounds(scrollEngine, displayOrder.size(), offsetY);
+        scrollEngine.jumpTo(folderScrollOffset);
+        state = MenuState::ShowFolders;
+    };
 
     Button largeCornerButton(SCREEN_WIDTH - 470, 0, 470, 160, largeCornerButtonTexture, font, BUTTON_X " Select", SCREEN_COLOR_BLACK);
     largeCornerButton.setOnClick([&]() {
-        if (images.empty()) {
+        if (displayOrder.empty() || state == MenuState::ShowFolders) {
             return;
         }
         if (state == MenuState::ShowAllImages) {
@@ -593,15 +1497,22 @@ int main() {
     bool isCameraScrolling = false;
     bool selectedImage = false;
     bool renderHover = true;
-    int initialTouchY = -1;
-    int initialSelectedImageIndex;
+    // Holding a tile in select mode, then dragging, applies the held tile's
+    // new state to every tile between it and the finger
+    int touchedImageIndex = -1;
+    Uint32 touchDownTicks = 0;
+    bool rangeSelecting = false;
+    SelectionModel rangeBase;
+    Uint32 lastInputTicks = SDL_GetTicks();
     SDL_Event event;
-    ImagePairScreen imagePairScreen(nullptr, arrowTexture, renderer);
     initializeGhostPointerTexture(renderer);
+    Uint64 lastFrameCounter = SDL_GetPerformanceCounter();
     while (!quit) {
+        uploadQueue.beginFrame();
         deleteImagesSelected = false;
         int x, y;
         while (SDL_PollEvent(&event)) {
+            lastInputTicks = SDL_GetTicks();
             cornerButton.handleEvent(event);
             largeCornerButton.handleEvent(event);
             if (state == MenuState::ShowSingleImage) {
@@ -624,54 +1535,123 @@ int main() {
                     }
                     break;
                 case SDL_CONTROLLERBUTTONDOWN:
+                    if (!renderHover && !displayOrder.empty() && !isImageVisible(selectedImageIndex, offsetY, scrollOffsetY, true)) {
+                        // Coming back from touch scrolling, pick up where the user is looking
+                        selectedImageIndex = findFirstVisibleImage(selectedImageIndex, displayOrder.size(), offsetY, scrollOffsetY);
+                    }
                     renderHover = true;
                     switch (event.cbutton.button) {
                         case SDL_CONTROLLER_BUTTON_A:
-                            if (!images.empty()) {
-                                if (state == MenuState::SelectImagesDelete) {
-                                    images[selectedImageIndex].selected = !images[selectedImageIndex].selected;
+                            if (!displayOrder.empty()) {
+                                if (state == MenuState::ShowFolders) {
+                                    openFolder(folderOrder[selectedImageIndex]);
+                                } else if (state == MenuState::SelectImagesDelete) {
+                                    selection.toggle(selectedImageIndex);
                                 } else if (state == MenuState::ShowAllImages) {
                                     state = MenuState::ShowSingleImage;
-                                    imagePairScreen.setImagePair(&images[selectedImageIndex]);
+                                    imagePairScreen.setImagePair(displayOrder[selectedImageIndex]);
+                                }
+                            }
+                            break;
+                        case SDL_CONTROLLER_BUTTON_Y:
+                            if (state == MenuState::SelectImagesDelete) {
+                                if (selection.count() == selection.size()) {
+                                    selection.clear();
+                                } else {
+                                    selection.selectAll();
+                                }
+                            } else if (state == MenuState::ShowAllImages && trashBin.canUndo()) {
+                                std::vector<uint32_t> restoredPairs;
+                                if (!trashBin.undoLastBatch(restoredPairs)) {
+                                    setStatusMessage("%u screenshots could not be restored, " BUTTON_Y " tries again",
+                                                     static_cast<unsigned>(lastTrashedPairs.size() - restoredPairs.size()));
+                                }
+                                std::vector<SlotHandle> restored;
+                                for (uint32_t index : restoredPairs) {
+                                    const TrashedPair &pair = lastTrashedPairs[index];
+                                    SlotHandle handle = library.add(pair.folder, pair.stem, pair.tvFormat, pair.drcFormat);
+                                    library.setCaptureTime(handle, pair.captureTime);
+                                    displayOrder.push_back(handle);
+                                    restored.push_back(handle);
                                 }
+                                // The rest stays undoable, numbered as the trash now numbers it
+                                for (auto it = restoredPairs.rbegin(); it != restoredPairs.rend(); ++it) {
+                                    lastTrashedPairs.erase(lastTrashedPairs.begin() + *it);
+                                }
+                                probeMetadata(metadataProber, restored);
+                                // Sorting puts the pairs back where they were
+                                sortImages(sortMode);
+                                updateFolderEntry(folderIndex, openedFolder);
+                                selection.resize(displayOrder.size());
+                                resetThumbnails(*thumbnailScheduler, uploadQueue);
+                                updateScrollBounds(scrollEngine, displayOrder.size(), offsetY);
+                            } else if (state == MenuState::ShowSingleImage) {
+                                imagePairScreen.toggleInfo();
+                            }
+                            break;
+                        case SDL_CONTROLLER_BUTTON_RIGHTSHOULDER:
+                            if (state == MenuState::ShowFolders || state == MenuState::ShowAllImages) {
+                                sortMode = getNextSortMode(sortMode);
+                                if (state == MenuState::ShowFolders) {
+                                    sortFolders(folderIndex, sortMode);
+                                } else {
+                                    sortImages(sortMode);
+                                }
+                                resetThumbnails(*thumbnailScheduler, uploadQueue);
+                                selectedImageIndex = 0;
+                                scrollEngine.scrollTo(0.0f);
+                            } else if (state == MenuState::SelectImagesDelete && !displayOrder.empty()) {
+                                selectSimilar(renderer, std::string(folderIndex.getDisplayName(openedFolder)));
+                                scrollToFirstSelected(scrollEngine, selectedImageIndex, offsetY);
+                            }
+                            break;
+                        case SDL_CONTROLLER_BUTTON_START:
+                            if (state == MenuState::SelectImagesDelete && selection.any()) {
+                                std::string title(folderIndex.getDisplayName(openedFolder));
+                                SelectionAction action = chooseSelectionAction(renderer, title);
+                                if (action == SelectionAction::ContactSheet) {
+                                    createContactSheet(renderer, title, true);
+                                } else if (action == SelectionAction::Optimize && optimizeStorage(renderer, title, true, *thumbnailScheduler, uploadQueue, metadataProber)) {
+                                    updateFolderEntry(folderIndex, openedFolder);
+                                } else if (action != SelectionAction::Cancelled) {
+                                    exportSelection(renderer, title, action == SelectionAction::Archive);
+                                }
+                            } else if (state == MenuState::ShowAllImages && !displayOrder.empty()) {
+                                createContactSheet(renderer, std::string(folderIndex.getDisplayName(openedFolder)), false);
+                            }
+                            break;
+                        case SDL_CONTROLLER_BUTTON_BACK:
+                            if (state == MenuState::SelectImagesDelete && !displayOrder.empty()) {
+                                selectDuplicates(renderer, std::string(folderIndex.getDisplayName(openedFolder)), folderIndex.getPath(openedFolder));
+                                scrollToFirstSelected(scrollEngine, selectedImageIndex, offsetY);
+                            } else if (state == MenuState::ShowAllImages && !displayOrder.empty() &&
+                                       optimizeStorage(renderer, std::string(folderIndex.getDisplayName(openedFolder)), false, *thumbnailScheduler, uploadQueue, metadataProber)) {
+                                updateFolderEntry(folderIndex, openedFolder);
+                            }
+                            break;
+                        case SDL_CONTROLLER_BUTTON_LEFTSHOULDER:
+                            if (state == MenuState::SelectImagesDelete && !displayOrder.empty()) {
+                                int first, last;
+                                getFolderRange(selectedImageIndex, first, last);
+                                selection.setRange(first, last, !selection.isRangeSelected(first, last));
+                            } else if (state == MenuState::ShowAllImages && !displayOrder.empty()) {
+                                runSlideshow(renderer, uploadQueue, selectedImageIndex);
+                                scrollToImage(scrollEngine, selectedImageIndex, offsetY);
                             }
                             break;
                         case SDL_CONTROLLER_BUTTON_DPAD_UP:
                             if (state != MenuState::ShowSingleImage) {
                                 if (selectedImageIndex >= GRID_SIZE) {
                                     selectedImageIndex -= GRID_SIZE;
-                                    if (isFirstRow(selectedImageIndex) || !isImageVisible(images[selectedImageIndex], scrollOffsetY, true)) {
-                                        if (scrollOffsetY >= 0) {
-                                            scrollOffsetY = 0;
-                                        } else {
-                                            scrollOffsetY += (GRID_SIZE - 1) * (IMAGE_HEIGHT + SEPARATION);
-                                            if (scrollOffsetY > 0) {
-                                                scrollOffsetY = 0;
-                                            }
-                                        }
-                                    }
+                                    scrollToImage(scrollEngine, selectedImageIndex, offsetY);
                                 }
                             }
                             break;
                         case SDL_CONTROLLER_BUTTON_DPAD_DOWN:
                             if (state != MenuState::ShowSingleImage) {
-                                if (selectedImageIndex < static_cast<int>(images.size()) - GRID_SIZE) {
+                                if (selectedImageIndex < static_cast<int>(displayOrder.size()) - GRID_SIZE) {
                                     selectedImageIndex += GRID_SIZE;
-                                    if (isLastRow(selectedImageIndex, images.size()) || !isImageVisible(images[selectedImageIndex], scrollOffsetY, true)) {
-                                        scrollOffsetY -= IMAGE_WIDTH + SEPARATION;
-                                        int lastRow = (images.size() - 1) / GRID_SIZE;
-                                        int lastVisibleRow = (lastRow * GRID_SIZE - 1) / GRID_SIZE;
-                                        int lastRowTop = -lastVisibleRow * (IMAGE_HEIGHT + SEPARATION);
-
-                                        if (scrollOffsetY <= lastRowTop) {
-                                            scrollOffsetY = lastRowTop;
-                                        } else {
-                                            scrollOffsetY -= (GRID_SIZE - 1) * (IMAGE_HEIGHT + SEPARATION);
-                                            if (scrollOffsetY < lastRowTop) {
-                                                scrollOffsetY = lastRowTop;
-                                            }
-                                        }
-                                    }
+                                    scrollToImage(scrollEngine, selectedImageIndex, offsetY);
                                 }
                             }
                             break;
@@ -684,7 +1664,7 @@ int main() {
                             break;
                         case SDL_CONTROLLER_BUTTON_DPAD_RIGHT:
                             if (state != MenuState::ShowSingleImage) {
-                                if (selectedImageIndex % GRID_SIZE != GRID_SIZE - 1 && selectedImageIndex < static_cast<int>(images.size()) - 1) {
+                                if (selectedImageIndex % GRID_SIZE != GRID_SIZE - 1 && selectedImageIndex < static_cast<int>(displayOrder.size()) - 1) {
                                     selectedImageIndex++;
                                 }
                             }
@@ -698,43 +1678,47 @@ int main() {
                     y = event.tfinger.y * SCREEN_HEIGHT;
                     pointerTexture.rect.x = x - pointerTexture.rect.w / 2;
                     pointerTexture.rect.y = y - pointerTexture.rect.h / 2;
-                    initialTouchY = y;
-                    initialSelectedImageIndex = selectedImageIndex;
                     pointerTrail.clear();
-                    if (state == MenuState::ShowAllImages) {
-                        for (const auto &image : images) {
-                            if (isPointInsideRect(x, y, IMAGE_WIDTH, IMAGE_HEIGHT, image.x, headerTexture.rect.h + image.y + scrollOffsetY)) {
-                                selectedImageIndex = static_cast<int>(std::distance(images.begin(), std::find(images.begin(), images.end(), image)));
-                                initialSelectedImageIndex = selectedImageIndex;
-                                break;
-                            }
+                    touchedImageIndex = findImageAt(x, y, offsetX, offsetY, scrollOffsetY);
+                    if (state == MenuState::ShowAllImages || state == MenuState::ShowFolders) {
+                        if (touchedImageIndex >= 0) {
+                            selectedImageIndex = touchedImageIndex;
                         }
                         if (!selectedImage) {
                             isCameraScrolling = true;
+                            scrollEngine.touchDown(event.tfinger.y * SCREEN_HEIGHT, event.tfinger.timestamp);
                         }
                     } else if (state == MenuState::SelectImagesDelete) {
-                        for (const auto &image : images) {
-                            if (isPointInsideRect(x, y, IMAGE_WIDTH, IMAGE_HEIGHT, image.x, headerTexture.rect.h + image.y + scrollOffsetY)) {
-                                selectedImageIndex = static_cast<int>(std::distance(images.begin(), std::find(images.begin(), images.end(), image)));
-                                images[selectedImageIndex].selected = !images[selectedImageIndex].selected;
-                                break;
-                            }
+                        if (touchedImageIndex >= 0) {
+                            selectedImageIndex = touchedImageIndex;
                         }
+                        touchDownTicks = event.tfinger.timestamp;
                         isCameraScrolling = true;
+                        scrollEngine.touchDown(event.tfinger.y * SCREEN_HEIGHT, event.tfinger.timestamp);
                     }
                     break;
                 case SDL_FINGERUP:
                     x = event.tfinger.x * SCREEN_WIDTH;
                     y = event.tfinger.y * SCREEN_HEIGHT;
-                    initialTouchY = -1;
                     isCameraScrolling = false;
                     selectedImage = false;
-                    if (state == MenuState::ShowAllImages) {
-                        if (isPointInsideRect(x, y, IMAGE_WIDTH, IMAGE_HEIGHT, images[selectedImageIndex].x, headerTexture.rect.h + images[selectedImageIndex].y + scrollOffsetY)) {
+                    scrollEngine.touchUp(event.tfinger.timestamp);
+                    // Toggled on release so a scroll that starts on a tile leaves it alone
+                    if (state == MenuState::SelectImagesDelete && !rangeSelecting && touchedImageIndex >= 0 && scrollEngine.getDragDistance() < TAP_SLOP) {
+                        selection.toggle(touchedImageIndex);
+                    }
+                    rangeSelecting = false;
+                    touchedImageIndex = -1;
+                    if (state == MenuState::ShowAllImages && !displayOrder.empty() && scrollEngine.getDragDistance() < TAP_SLOP) {
+                        if (findImageAt(x, y, offsetX, offsetY, scrollOffsetY) == selectedImageIndex) {
                             state = MenuState::ShowSingleImage;
-                            imagePairScreen.setImagePair(&images[selectedImageIndex]);
+                            imagePairScreen.setImagePair(displayOrder[selectedImageIndex]);
                             selectedImage = true;
                         }
+                    } else if (state == MenuState::ShowFolders && !displayOrder.empty() && scrollEngine.getDragDistance() < TAP_SLOP) {
+                        if (findImageAt(x, y, offsetX, offsetY, scrollOffsetY) == selectedImageIndex) {
+                            openFolder(folderOrder[selectedImageIndex]);
+                        }
                     }
                     break;
                 case SDL_FINGERMOTION:
@@ -747,30 +1731,16 @@ int main() {
                     if (pointerTrail.size() > TRAIL_LENGTH) {
                         pointerTrail.erase(pointerTrail.begin());
                     }
-                    if (initialTouchY != -1 && isCameraScrolling) {
-                        renderHover = false;
-                        int touchDeltaY = y - initialTouchY;
-                        scrollOffsetY += touchDeltaY;
-                        int maxScrollOffsetY = (GRID_SIZE - 1) * (IMAGE_HEIGHT + SEPARATION);
-                        if (scrollOffsetY > 0) {
-                            scrollOffsetY = 0;
-                        } else if (scrollOffsetY < -maxScrollOffsetY) {
-                            scrollOffsetY = -maxScrollOffsetY;
+                    if (rangeSelecting) {
+                        int index = findImageAt(x, y, offsetX, offsetY, scrollOffsetY);
+                        if (index >= 0) {
+                            selection = rangeBase;
+                            selection.setRange(touchedImageIndex, index, rangeBase.isSelected(touchedImageIndex));
+                            selectedImageIndex = index;
                         }
-
-                        int rowsScrolled = std::abs(scrollOffsetY) / (IMAGE_HEIGHT + SEPARATION);
-                        int newRow = initialSelectedImageIndex / GRID_SIZE;
-                        if (scrollOffsetY > 0) {
-                            newRow -= rowsScrolled;
-                        } else if (scrollOffsetY < 0) {
-                            newRow += rowsScrolled - 1;
-                        }
-
-                        newRow = std::max(0, std::min(newRow, (int) ((images.size() - 1) / GRID_SIZE)));
-
-                        selectedImageIndex = std::clamp(newRow * GRID_SIZE + (initialSelectedImageIndex % GRID_SIZE), 0, (int) images.size() - 1);
-
-                        initialTouchY = y;
+                    } else if (isCameraScrolling) {
+                        renderHover = false;
+                        scrollEngine.touchMove(event.tfinger.y * SCREEN_HEIGHT, event.tfinger.timestamp);
                     }
                     break;
                 default:
@@ -778,61 +1748,91 @@ int main() {
             }
         }
 
+        if (state == MenuState::SelectImagesDelete && isCameraScrolling && !rangeSelecting && touchedImageIndex >= 0 &&
+            scrollEngine.getDragDistance() < TAP_SLOP && SDL_GetTicks() - touchDownTicks >= RANGE_SELECT_HOLD_MS) {
+            selection.toggle(touchedImageIndex);
+            rangeBase = selection;
+            rangeSelecting = true;
+            scrollEngine.stop();
+        }
+
         if (deleteImagesSelected) {
             if (showConfirmationDialog(renderer, &quit)) {
-                if (std::any_of(images.begin(), images.end(), [](const ImagesPair &image) { return image.selected; })) {
-                    std::vector<ImagesPair> removedImages;
-                    for (auto &image : images) {
-                        if (image.selected) {
-                            removedImages.push_back(image);
-                            if (!image.pathTV.empty()) {
-                                std::filesystem::remove(image.pathTV);
-                            }
-                            if (!image.pathDRC.empty()) {
-                                std::filesystem::remove(image.pathDRC);
-                            }
-                            if (image.textureTV && image.textureTV != blackTexture) {
-                                SDL_DestroyTexture(image.textureTV);
-                                image.textureTV = nullptr;
-                            }
-                            if (image.textureDRC && image.textureDRC != blackTexture) {
-                                SDL_DestroyTexture(image.textureDRC);
-                                image.textureDRC = nullptr;
-                            }
+                if (selection.any()) {
+                    // Each pair is moved to the trash and freed in O(1), then the
+                    // display order is compacted in one pass between selected indices
+                    trashBin.beginBatch();
+                    lastTrashedPairs.clear();
+                    std::vector<std::string> pairPaths;
+                    size_t kept = 0;
+                    size_t next = 0;
+                    selection.forEachSelected([&](size_t index) {
+                        SlotHandle handle = displayOrder[index];
+                        pairPaths.clear();
+                        if (library.getFlags(handle) & IMAGE_FLAG_HAS_TV) {
+                            pairPaths.push_back(library.getPathTV(handle));
                         }
-                    }
-                    for (const auto &image : removedImages) {
-                        auto it = std::find(images.begin(), images.end(), image);
-                        if (it != images.end()) {
-                            images.erase(it);
+                        if (library.getFlags(handle) & IMAGE_FLAG_HAS_DRC) {
+                            pairPaths.push_back(library.getPathDRC(handle));
                         }
-                    }
-                    removedImages.clear();
-                    removedImages.shrink_to_fit();
+                        if (!trashBin.moveToTrash(pairPaths)) {
+                            // Stays in the grid, it is compacted along with the kept pairs
+                            return;
+                        }
+                        lastTrashedPairs.push_back({library.getFolder(handle), std::string(library.getStem(handle)), library.getFormat(handle, ScreenshotKind::TV),
+                                                    library.getFormat(handle, ScreenshotKind::DRC), library.getCaptureTime(handle)});
+                        releaseThumbnail(handle);
+                        library.remove(handle);
+                        std::move(displayOrder.begin() + next, displayOrder.begin() + index, displayOrder.begin() + kept);
+                        kept += index - next;
+                        next = index + 1;
+                    });
+                    std::move(displayOrder.begin() + next, displayOrder.end(), displayOrder.begin() + kept);
+                    displayOrder.resize(kept + displayOrder.size() - next);
+                    updateFolderEntry(folderIndex, openedFolder);
+                    selection.resize(displayOrder.size());
                     selectedImageIndex = 0;
-                    int totalImages = static_cast<int>(images.size());
-                    for (int i = 0; i < totalImages; ++i) {
-                        int row = i / GRID_SIZE;
-                        int col = i % GRID_SIZE;
-                        images[i].x = offsetX + col * (IMAGE_WIDTH + SEPARATION);
-                        images[i].y = offsetY + row * (IMAGE_WIDTH + SEPARATION);
-                    }
+                    resetThumbnails(*thumbnailScheduler, uploadQueue);
+                    updateScrollBounds(scrollEngine, displayOrder.size(), offsetY);
                 }
                 state = MenuState::ShowAllImages;
             }
         }
 
+        if (closeFolderSelected) {
+            closeFolderSelected = false;
+            closeFolder();
+        }
+
+        Uint64 frameCounter = SDL_GetPerformanceCounter();
+        float frameSeconds = static_cast<float>(frameCounter - lastFrameCounter) / SDL_GetPerformanceFrequency();
+        lastFrameCounter = frameCounter;
+        scrollEngine.update(std::min(frameSeconds, 0.1f));
+        trashBin.setIdle(SDL_GetTicks() - lastInputTicks > TRASH_IDLE_MS && !isCameraScrolling && !scrollEngine.isMoving());
+        scrollOffsetY = std::lround(scrollEngine.getOffset());
+        collectMetadata(metadataProber);
+        if (state != MenuState::ShowSingleImage) {
+            updateThumbnails(*thumbnailScheduler, uploadQueue, scrollEngine, offsetY);
+        }
+
         SDL_RenderClear(renderer);
         SDL_RenderCopy(renderer, backgroundTexture.texture, nullptr, &backgroundTexture.rect);
         renderBackgroundParticles(renderer, particles, particleTexture);
         if (state != MenuState::ShowSingleImage) {
-            if (images.empty()) {
+            if (displayOrder.empty()) {
                 FC_Draw(font, renderer, SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2, "No images found");
                 SDL_RenderPresent(renderer);
             } else {
-                for (const auto &image : images) {
-                    if (isImageVisible(image, scrollOffsetY, false)) {
-                        renderImage(renderer, image, scrollOffsetY, state);
+                for (int i = getFirstDrawnImage(offsetY, scrollOffsetY); i < static_cast<int>(displayOrder.size()) && isImageVisible(i, offsetY, scrollOffsetY, false); i++) {
+                    SlotHandle handle = displayOrder[i];
+                    if (state == MenuState::ShowFolders) {
+                        ScreenshotKind coverKind = library.getFlags(handle) & IMAGE_FLAG_HAS_TV ? ScreenshotKind::TV : ScreenshotKind::DRC;
+                        uint16_t cover = coverKind == ScreenshotKind::TV ? library.getThumbnailTV(handle) : library.getThumbnailDRC(handle);
+                        renderFolder(renderer, getThumbnailTexture(cover), library.getInfo(handle, coverKind), getImagePosition(i, offsetX, offsetY, scrollOffsetY), folderIndex.getDisplayName(folderOrder[i]),
+                                     folderIndex.get(folderOrder[i]).pairCount);
+                    } else {
+                        renderImage(renderer, getThumbnailTexture(library.getThumbnailTV(handle)), getThumbnailTexture(library.getThumbnailDRC(handle)),
+                                    library.getInfo(handle, ScreenshotKind::TV), library.getInfo(handle, ScreenshotKind::DRC), getImagePosition(i, offsetX, offsetY, scrollOffsetY), selection.isSelected(i), state);
                     }
                 }
 
@@ -844,15 +1844,30 @@ int main() {
                     SDL_RenderCopy(renderer, backGraphicTexture.texture, nullptr, &backGraphicTexture.rect);
                     largeCornerButton.setTextColor(SCREEN_COLOR_WHITE);
                     largeCornerButton.setText(BUTTON_X " Delete");
-                } else {
+                    FC_DrawAlign(font, renderer, SCREEN_WIDTH / 2, SCREEN_HEIGHT - 80, FC_ALIGN_CENTER, "%u selected    " BUTTON_Y " All    " BUTTON_L " Folder    " BUTTON_R " Similar    " BUTTON_MINUS " Duplicates    " BUTTON_PLUS " Export",
+                                 static_cast<unsigned>(selection.count()));
+                } else if (state == MenuState::ShowAllImages) {
                     SDL_SetTextureColorMod(largeCornerButtonTexture, 255, 255, 255);
+                    SDL_SetTextureBlendMode(backGraphicTexture.texture, SDL_BLENDMODE_BLEND);
+                    cornerButton.render(renderer);
+                    SDL_RenderCopy(renderer, backGraphicTexture.texture, nullptr, &backGraphicTexture.rect);
                     largeCornerButton.setTextColor(SCREEN_COLOR_BLACK);
                     largeCornerButton.setText(BUTTON_X " Select");
+                    FC_DrawAlign(font, renderer, SCREEN_WIDTH / 2, SCREEN_HEIGHT - 80, FC_ALIGN_CENTER, BUTTON_R " %s    " BUTTON_L " Slideshow    " BUTTON_PLUS " Contact sheet    " BUTTON_MINUS " Optimize%s", getSortModeName(sortMode),
+                                 trashBin.canUndo() ? "    " BUTTON_Y " Undo delete" : "");
+                } else {
+                    FC_DrawAlign(font, renderer, SCREEN_WIDTH / 2, SCREEN_HEIGHT - 80, FC_ALIGN_CENTER, BUTTON_R " %s", getSortModeName(sortMode));
+                }
+                if (SDL_GetTicks() - statusMessageTicks < STATUS_MESSAGE_MS) {
+                    FC_DrawAlign(font, renderer, SCREEN_WIDTH / 2, SCREEN_HEIGHT - 80 - FONT_SIZE - 12, FC_ALIGN_CENTER, "%s", statusMessage);
+                }
+                renderHeader(renderer, font, headerTexture, openedFolder >= 0 ? std::string(folderIndex.getDisplayName(openedFolder)) : "Album");
+                if (state != MenuState::ShowFolders) {
+                    largeCornerButton.render(renderer);
                 }
-                renderHeader(renderer, font, headerTexture);
-                largeCornerButton.render(renderer);
                 if (renderHover) {
-                    drawRect(renderer, images[selectedImageIndex].x - IMAGE_WIDTH * 0.05, headerTexture.rect.h + images[selectedImageIndex].y + scrollOffsetY - IMAGE_HEIGHT * 0.05, IMAGE_WIDTH * 1.1, IMAGE_HEIGHT * 1.5, 7, SCREEN_COLOR_YELLOW);
+                    SDL_Point position = getImagePosition(selectedImageIndex, offsetX, offsetY, scrollOffsetY);
+                    drawRect(renderer, position.x - IMAGE_WIDTH * 0.05, position.y - IMAGE_HEIGHT * 0.05, IMAGE_WIDTH * 1.1, IMAGE_HEIGHT * 1.5, 7, SCREEN_COLOR_YELLOW);
                 }
             }
             if (isCameraScrolling) {
@@ -861,9 +1876,10 @@ int main() {
                 SDL_SetTextureColorMod(pointerTexture.texture, 144, 238, 144);
                 SDL_RenderCopy(renderer, pointerTexture.texture, nullptr, &pointerTexture.rect);
             }
+            uploadQueue.endFrame();
             SDL_RenderPresent(renderer);
-        } else if (state == MenuState::ShowSingleImage && selectedImageIndex >= 0 && selectedImageIndex < static_cast<int>(images.size())) {
-            imagePairScreen.render();
+        } else if (state == MenuState::ShowSingleImage && selectedImageIndex >= 0 && selectedImageIndex < static_cast<int>(displayOrder.size())) {
+            imagePairScreen.render(std::min(frameSeconds, 0.1f));
             SDL_SetTextureBlendMode(backGraphicTexture.texture, SDL_BLENDMODE_BLEND);
             cornerButton.render(renderer);
             SDL_RenderCopy(renderer, backGraphicTexture.texture, nullptr, &backGraphicTexture.rect);
@@ -873,19 +1889,28 @@ int main() {
                 SDL_SetTextureColorMod(pointerTexture.texture, 144, 238, 144);
                 SDL_RenderCopy(renderer, pointerTexture.texture, nullptr, &pointerTexture.rect);
             }
+            uploadQueue.endFrame();
             SDL_RenderPresent(renderer);
         }
         cornerButton.updateButton(x, y, event.type == SDL_FINGERUP);
         largeCornerButton.updateButton(x, y, event.type == SDL_FINGERUP);
+        startBackgroundMusic();
     }
 
-    for (const auto &img : images) {
-        if (img.textureTV) {
-            SDL_DestroyTexture(img.textureTV);
-        }
-        if (img.textureDRC) {
-            SDL_DestroyTexture(img.textureDRC);
-        }
+    folderIndex.save();
+    if (openedFolder >= 0 && hashCacheDirty) {
+        saveHashCache(folderIndex.getPath(openedFolder), library, displayOrder);
+    }
+    thumbnailScheduler.reset();
+    uploadQueue.clear();
+    imagePairScreen.releaseTextures();
+    for (SlotHandle handle : displayOrder) {
+        releaseThumbnail(handle);
+    }
+    library.clear();
+    thumbnailPool.reset();
+    if (placeholderTexture) {
+        SDL_DestroyTexture(placeholderTexture);
     }
     if (blackTexture) {
         SDL_DestroyTexture(blackTexture);
@@ -908,24 +1933,22 @@ int main() {
     if (orbTexture) {
         SDL_DestroyTexture(orbTexture);
     }
-    if (particleTexture) {
-        SDL_DestroyTexture(particleTexture);
-    }
     if (largeCornerButtonTexture) {
         SDL_DestroyTexture(largeCornerButtonTexture);
     }
-    if (pointerTexture.texture) {
-        SDL_DestroyTexture(pointerTexture.texture);
-    }
     if (ghostPointerTexture) {
         SDL_DestroyTexture(ghostPointerTexture);
     }
 
     FC_FreeFont(font);
     font = nullptr;
-    Mix_FreeMusic(backgroundMusic);
-    bgmBuffer = nullptr;
-    Mix_CloseAudio();
+    if (backgroundMusic) {
+        Mix_FreeMusic(backgroundMusic);
+        backgroundMusic = nullptr;
+    }
+    if (audioOpened) {
+        Mix_CloseAudio();
+    }
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
     SDL_Quit();